@@ -0,0 +1,108 @@
+/*
+* anim_bench - cpu cost of the piece animations with many of them at once
+*
+* usage: anim_bench [animations] [rounds]
+*
+* Each round starts the given number of animations (default 10000) with staggered
+* starts and runs 60 frames per second of clock until all are done, evaluating and
+* applying the positions like the ui does. Frames are not paced, only the update
+* is timed. For comparison the former scheme, one std::queue of precomputed
+* matrices per move popped once per frame, is timed on the same moves.
+*/
+
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <queue>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/spline.hpp>
+
+#include "animation.h"
+
+static double elapsed (std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Move {
+    glm::vec3   from, to;
+    double      start;
+    float       duration;
+};
+
+int main (int argc, const char* argv[]) {
+    int count   = argc > 1 ? atoi(argv[1]) : 10000;
+    int rounds  = argc > 2 ? atoi(argv[2]) : 10;
+    const double frame = 1.0 / 60.0;
+    const glm::vec3 vUp = glm::vec3(0.f,-10.f,0.f);
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> square(-7.f, 7.f);
+    std::vector<Move> moves(count);
+    for (Move& m : moves) {
+        m.from      = glm::vec3(square(rng), 0.f, square(rng));
+        m.to        = glm::vec3(square(rng), 0.f, square(rng));
+        m.start     = std::uniform_real_distribution<double>(0.0, 0.25)(rng);
+        m.duration  = std::uniform_real_distribution<float>(0.4f, 0.6f)(rng);
+    }
+    std::vector<glm::vec3> positions(count);//stands for the instance buffer
+
+    AnimationPool pool(count);
+    uint64_t updates = 0;
+    double time = 0;
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < count; i++)
+            pool.add(i, moves[i].from+vUp, moves[i].from, moves[i].to, moves[i].to+vUp,
+                     moves[i].start, moves[i].duration, Easing::EaseInOut);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (double now = 0; pool.size(); now += frame) {
+            updates += pool.size();
+            pool.update(now, [&](uint32_t target, const glm::vec3& pos) { positions[target] = pos; });
+        }
+        time += elapsed(start);
+    }
+
+    //former scheme: matrices computed when the move starts, one popped per frame
+    uint64_t queueUpdates = 0;
+    double queueTime = 0;
+    const int steps = 60;
+    for (int r = 0; r < rounds; r++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<std::queue<glm::mat4>> queues(count);
+        for (int i = 0; i < count; i++)
+            for (int s = 0; s <= steps; s++)
+                queues[i].push(glm::translate(glm::mat4(1.0), glm::catmullRom(moves[i].from+vUp, moves[i].from,
+                               moves[i].to, moves[i].to+vUp, (float)s / steps)));
+        bool running = true;
+        while (running) {
+            running = false;
+            for (int i = 0; i < count; i++) {
+                if (queues[i].empty())
+                    continue;
+                positions[i] = glm::vec3(queues[i].front()[3]);
+                queues[i].pop();
+                queueUpdates++;
+                running = true;
+            }
+        }
+        queueTime += elapsed(start);
+    }
+
+    float check = 0;
+    for (const glm::vec3& p : positions)
+        check += p.x + p.y + p.z;
+
+    std::cout << count << " animations, " << rounds << " rounds" << std::endl;
+    std::cout << std::left << std::setw(16) << "scheme" << std::right << std::setw(14) << "updates"
+              << std::setw(10) << "ms" << std::setw(14) << "ns/update" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::left << std::setw(16) << "pool (soa)" << std::right << std::setw(14) << updates
+              << std::setw(10) << time * 1000 << std::setw(14) << time * 1e9 / updates << std::endl;
+    std::cout << std::left << std::setw(16) << "matrix queues" << std::right << std::setw(14) << queueUpdates
+              << std::setw(10) << queueTime * 1000 << std::setw(14) << queueTime * 1e9 / queueUpdates << std::endl;
+    std::cout << "checksum " << check << std::endl;
+    return 0;
+}
@@ -0,0 +1,71 @@
+/*
+* chess_bench - move generator speed and correctness on the reference perft positions
+*
+* usage: chess_bench [depth] [-j threads] [position name...]
+*
+* Every depth from 1 to the requested one (default 5) is run on each position and
+* compared to the published node count by runPerftSuite. Generation alone is then timed by calling
+* generateLegal repeatedly, as the ui does on each selection. With -j the requested
+* depth is also run by the multi threaded perft. Exit status is the number of wrong
+* counts.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "position.h"
+#include "perft.h"
+#include "parallelperft.h"
+
+using namespace chess;
+
+static double elapsed (std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main (int argc, const char* argv[]) {
+    int maxDepth = argc > 1 ? atoi(argv[1]) : 5;
+    int threads = 0;
+    std::vector<const char*> names;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i+1 < argc)
+            threads = atoi(argv[++i]);
+        else
+            names.push_back(argv[i]);
+    }
+    initBitboards();
+
+    PerftSuiteStats stats;
+    int errors = runPerftSuite(maxDepth, names, &stats);
+    std::cout << "perft: " << stats.nodes << " nodes in " << std::setprecision(3) << stats.seconds << "s, "
+              << (uint64_t)(stats.seconds > 0 ? stats.nodes / stats.seconds : 0) << " nodes/s" << std::endl;
+
+    //legal move generation alone, the cost paid on each piece selection
+    const int calls = 200000;
+    uint64_t moves = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < perftPositionsCount; i++) {
+        Position pos;
+        pos.setFen(perftPositions[i].fen);
+        for (int n = 0; n < calls; n++) {
+            MoveList list;
+            pos.generateLegal(list);
+            moves += list.size();
+        }
+    }
+    double t = elapsed(start);
+    std::cout << "generateLegal: " << (uint64_t)(calls * perftPositionsCount / t) << " calls/s, "
+              << (uint64_t)(moves / t) << " moves/s" << std::endl;
+
+    if (threads > 0) {
+        std::cout << "parallel perft:" << std::endl;
+        errors += runParallelPerftSuite(maxDepth, threads);
+    }
+
+    std::cout << (errors ? "FAILED" : "all counts ok") << std::endl;
+    return errors;
+}
@@ -0,0 +1,138 @@
+/*
+* cull_bench - cpu frustum culling of a stress scene of many boards
+*
+* usage: cull_bench [grid] [frames]
+*
+* Scenes of 1, 2, 4... up to grid (default 16) boards per side are laid out like the
+* one of vkChess: frame, 64 squares, the 32 pieces of the start position and the
+* two hidden spare queens. Bounding spheres are approximations of the meshes of
+* data/models/chess.gltf. A camera with the perspective of the ui turns around the
+* scene for the given number of frames (default 120), each frame is culled by
+* cullInstances. Exit status is the number of frames it failed on.
+*
+* This is the reference a culled renderer is to be built on, the scene renderer of
+* vkChess still draws every instance.
+*/
+
+#include <stdlib.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "culling.h"
+
+//primitives of the model, squares are one each as their mesh is at its place on the board
+enum { Frame, Pawn, Rook, Knight, Bishop, Queen, King, FirstSquare, PrimitiveCount = FirstSquare + 64 };
+
+static const float boardSpacing = 20.f;
+
+static double elapsed (std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static glm::vec3 squareCenter (int x, int y) {
+    return glm::vec3(x*2 - 7, 0.f, 7 - y*2);
+}
+
+static void addInstance (std::vector<CullInstance>& instances, uint32_t primitive, const glm::mat4& model) {
+    CullInstance inst = {};
+    inst.model      = model;
+    inst.primitive  = primitive;
+    instances.push_back(inst);
+}
+
+//grid x grid boards, draws get their firstInstance but no mesh as nothing is drawn
+static void buildScene (int grid, std::vector<CullInstance>& instances, std::vector<DrawIndexedIndirect>& draws) {
+    static const uint32_t backRank[8] = {Rook, Knight, Bishop, Queen, King, Bishop, Knight, Rook};
+    std::vector<CullInstance> unsorted;
+    for (int bx = 0; bx < grid; bx++)
+        for (int by = 0; by < grid; by++) {
+            glm::vec3 offset = glm::vec3((bx - (grid - 1) * 0.5f) * boardSpacing, 0.f,
+                                         (by - (grid - 1) * 0.5f) * boardSpacing);
+            glm::mat4 board = glm::translate(glm::mat4(1.0), offset);
+            addInstance(unsorted, Frame, board);
+            for (int i = 0; i < 64; i++)
+                addInstance(unsorted, FirstSquare + i, board);
+            for (int x = 0; x < 8; x++) {
+                addInstance(unsorted, backRank[x], glm::translate(board, squareCenter(x, 0)));
+                addInstance(unsorted, backRank[x], glm::translate(board, squareCenter(x, 7)));
+                addInstance(unsorted, Pawn, glm::translate(board, squareCenter(x, 1)));
+                addInstance(unsorted, Pawn, glm::translate(board, squareCenter(x, 6)));
+            }
+            for (int c = 0; c < 2; c++)
+                addInstance(unsorted, Queen, glm::scale(glm::mat4(1.0), glm::vec3(0.f)));
+        }
+    //instances grouped by primitive, so each draw has its own range of visible
+    draws.assign(PrimitiveCount, DrawIndexedIndirect());
+    for (const CullInstance& inst : unsorted)
+        draws[inst.primitive].instanceCount++;
+    uint32_t first = 0;
+    for (DrawIndexedIndirect& d : draws) {
+        d.firstInstance = first;
+        first += d.instanceCount;
+        d.instanceCount = 0;
+    }
+    instances.resize(unsorted.size());
+    for (const CullInstance& inst : unsorted) {
+        DrawIndexedIndirect& d = draws[inst.primitive];
+        instances[d.firstInstance + d.instanceCount++] = inst;
+    }
+}
+
+static std::vector<glm::vec4> primitiveSpheres () {
+    std::vector<glm::vec4> spheres(PrimitiveCount);
+    spheres[Frame] = glm::vec4(0.f, 0.f, 0.f, 12.f);
+    //pieces stand on their origin and go up along -y
+    for (int p = Pawn; p <= King; p++)
+        spheres[p] = glm::vec4(0.f, -1.2f, 0.f, p == Pawn ? 1.2f : 1.8f);
+    for (int i = 0; i < 64; i++)
+        spheres[FirstSquare + i] = glm::vec4(squareCenter(i % 8, i / 8), 1.42f);
+    return spheres;
+}
+
+int main (int argc, const char* argv[]) {
+    int maxGrid = argc > 1 ? std::max(1, atoi(argv[1])) : 16;
+    int frames  = argc > 2 ? std::max(1, atoi(argv[2])) : 120;
+
+    std::vector<CullInstance> instances;
+    std::vector<DrawIndexedIndirect> draws;
+    std::vector<glm::vec4> spheres = primitiveSpheres();
+
+    const glm::mat4 projection = glm::perspective(glm::radians(50.f), 16.f / 9.f, 0.1f, 50.f);
+    int failures = 0;
+    std::cout << std::setw(8) << "boards" << std::setw(10) << "instances" << std::setw(10) << "visible"
+              << std::setw(10) << "cpu ms" << std::setw(10) << "failed" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (int grid = 1; grid <= maxGrid; grid *= 2) {
+        buildScene(grid, instances, draws);
+        std::vector<uint32_t> visible(instances.size());
+
+        double cpuTime = 0;
+        uint64_t visibleCount = 0;
+        int failed = 0;
+        //orbit over the scene looking down like the ui camera
+        float radius = std::max(15.f, grid * boardSpacing * 0.25f);
+        for (int f = 0; f < frames; f++) {
+            float a = f * 6.2831853f / frames;
+            glm::vec3 eye = glm::vec3(std::sin(a) * radius, -12.f, std::cos(a) * radius);
+            glm::vec3 target = eye + glm::vec3(-std::sin(a) * 15.f, 12.f, -std::cos(a) * 15.f);
+            Frustum frustum = Frustum::fromMatrix(projection * glm::lookAt(eye, target, glm::vec3(0.f, -1.f, 0.f)));
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            if (!cullInstances(frustum, instances, spheres, draws, visible))
+                failed++;
+            cpuTime += elapsed(start);
+            for (const DrawIndexedIndirect& d : draws)
+                visibleCount += d.instanceCount;
+        }
+        failures += failed;
+        std::cout << std::setw(8) << grid * grid << std::setw(10) << instances.size()
+                  << std::setw(10) << visibleCount / frames << std::setw(10) << cpuTime * 1000 / frames
+                  << std::setw(10) << failed << std::endl;
+    }
+    return failures;
+}
@@ -0,0 +1,190 @@
+#include <string.h>
+#include <iostream>
+#include <deque>
+#include <thread>
+#include <chrono>
+
+#include "analysis.h"
+#include "pgn.h"
+#include "position.h"
+#include "enginepool.h"
+
+//one position sent to the engines, kept until written in input order
+struct AnalysedPosition {
+    int             game;
+    int             ply;
+    std::string     move;
+    chess::Color    side;//side to move, engine scores are given for it
+    bool            done = false;
+    EngineResult    result;
+};
+
+static void writeLine (const AnalysedPosition& a) {
+    std::cout << a.game << '\t' << a.ply << '\t' << a.move << '\t';
+    const UciMessage& best = a.result.best;
+    const UciMessage& info = a.result.info;
+    if (best.type != UciMessage::BestMove) {
+        std::cout << "error\t0\t-" << std::endl;
+        return;
+    }
+    if (info.hasScore) {
+        int score = a.side == chess::White ? info.score : -info.score;
+        if (info.mateScore)
+            std::cout << '#';
+        std::cout << score;
+    } else
+        std::cout << '-';
+    std::cout << '\t' << info.depth << '\t' << best.bestMove << std::endl;
+}
+
+//Produces the positions to evaluate one at a time, so only the positions in
+//flight are kept whatever the input size.
+class PositionSource {
+public:
+    PositionSource (const MappedFile& file, bool epd) :
+        data(file.data), end(file.data + file.size), epd(epd), pgn(file.data, file.size) {}
+
+    //fill position and record, false at end of input
+    bool next (chess::Position& pos, AnalysedPosition& rec) {
+        return epd ? nextEpd(pos, rec) : nextPgn(pos, rec);
+    }
+    int skipped = 0;//invalid epd lines and pgn games not or partly analysed
+
+private:
+    const char*     data;
+    const char*     end;
+    bool            epd;
+    PgnReader       pgn;
+    PgnGame         game;
+    chess::Position gamePos;
+    int             gameIndex   = 0;
+    size_t          ply         = 0;//next move of game to play
+    bool            gameValid   = false;
+
+    bool nextEpd (chess::Position& pos, AnalysedPosition& rec) {
+        while (data < end) {
+            const char* nl = (const char*)memchr(data, '\n', end - data);
+            const char* lineEnd = nl ? nl : end;
+            const char* line = data;
+            data = nl ? nl + 1 : end;
+            gameIndex++;
+            if (lineEnd == line || *line == '#' || *line == '\r')
+                continue;
+            if (!pos.setFen(std::string(line, lineEnd - line))) {
+                std::cerr << "line " << gameIndex << ": invalid epd" << std::endl;
+                skipped++;
+                continue;
+            }
+            rec.game    = gameIndex;
+            rec.ply     = 0;
+            rec.move    = "-";
+            return true;
+        }
+        return false;
+    }
+    bool nextPgn (chess::Position& pos, AnalysedPosition& rec) {
+        while (true) {
+            if (!gameValid || ply == game.moves.size()) {
+                if (!pgn.next(game))
+                    return false;
+                gameIndex++;
+                ply = 0;
+                gameValid = true;
+                if (game.fen.length) {
+                    gameValid = gamePos.setFen(std::string(game.fen.str, game.fen.length));
+                    if (!gameValid) {
+                        std::cerr << "game " << gameIndex << ": invalid FEN tag" << std::endl;
+                        skipped++;
+                    }
+                } else
+                    gamePos.setStartPosition();
+                continue;
+            }
+            const PgnToken& tok = game.moves[ply];
+            chess::Move m = gamePos.parseSan(tok.str, tok.length);
+            if (m == chess::NoMove) {
+                std::cerr << "game " << gameIndex << ": illegal move " << std::string(tok.str, tok.length)
+                          << " at ply " << ply + 1 << ", rest of the game skipped" << std::endl;
+                skipped++;
+                gameValid = false;
+                continue;
+            }
+            gamePos.doMove(m);
+            ply++;
+            pos         = gamePos;
+            rec.game    = gameIndex;
+            rec.ply     = ply;
+            rec.move    = chess::moveToUci(m);
+            return true;
+        }
+    }
+};
+
+int runAnalysis (const std::string& engineCommand, const char* path, int engines, const std::string& goCommand) {
+    MappedFile file;
+    if (!file.open(path)) {
+        std::cerr << "Unable to read " << path << std::endl;
+        return 1;
+    }
+    size_t nameLength = strlen(path);
+    bool epd = nameLength > 4 && strcmp(path + nameLength - 4, ".epd") == 0;
+
+    EnginePool pool;
+    if (!pool.start(engineCommand, engines))
+        return 1;
+
+    PositionSource source(file, epd);
+    std::deque<AnalysedPosition> inFlight;
+    int firstId = 0, nextId = 0, errors = 0;
+    bool inputDone = false;
+    const size_t maxInFlight = 4 * engines;//keeps every engine busy while results are collected
+    std::vector<EngineResult> results;
+
+    std::cout << "game\tply\tmove\tscore\tdepth\tbestmove" << std::endl;
+    while (!inputDone || !inFlight.empty()) {
+        bool alive = false;
+        for (size_t i = 0; i < pool.size(); i++)
+            alive |= pool[i].alive();
+        if (!alive) {
+            std::cerr << "No engine left running" << std::endl;
+            return errors + inFlight.size() + 1;
+        }
+
+        while (!inputDone && inFlight.size() < maxInFlight) {
+            chess::Position pos;
+            AnalysedPosition rec;
+            if (!source.next(pos, rec)) {
+                inputDone = true;
+                break;
+            }
+            rec.side = pos.side;
+            EngineJob job;
+            job.id          = nextId++;
+            job.position    = "position fen " + pos.fen();
+            job.go          = goCommand;
+            pool.submit(job);
+            inFlight.push_back(rec);
+        }
+
+        results.clear();
+        pool.poll(results);
+        for (const EngineResult& r : results) {
+            AnalysedPosition& a = inFlight[r.id - firstId];
+            a.result = r;
+            a.done = true;
+        }
+        //written in input order
+        while (!inFlight.empty() && inFlight.front().done) {
+            writeLine(inFlight.front());
+            if (inFlight.front().result.best.type != UciMessage::BestMove)
+                errors++;
+            inFlight.pop_front();
+            firstId++;
+        }
+        if (results.empty())
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    std::cerr << nextId << " positions analysed, " << source.skipped << " invalid inputs skipped, "
+              << errors << " errors" << std::endl;
+    return errors;
+}
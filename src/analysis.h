@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+
+//Evaluate every position of a pgn or epd file (epd if the name ends with .epd)
+//with a pool of engines, the file is memory mapped and scanned in place. One tab
+//separated line is written to stdout per position as soon as it and all the
+//previous ones are evaluated:
+//  game  ply  move  score  depth  bestmove
+//Pgn positions are the ones after each move of the main line, epd positions get
+//ply 0 and move '-'. Score is in centipawns from white point of view, or #n for
+//a mate in n moves (#-n if black mates). Return the number of positions that
+//could not be evaluated.
+int runAnalysis (const std::string& engineCommand, const char* path, int engines, const std::string& goCommand);
@@ -0,0 +1,158 @@
+#include <algorithm>
+
+#include "animation.h"
+
+//ease(t) = a t^3 + b t^2 + c t, in Easing order, so easing needs no branch
+static const float easeCoefs[4][3] = {
+    { 0.f, 0.f, 1.f},//linear
+    { 0.f, 1.f, 0.f},//ease in
+    { 0.f,-1.f, 2.f},//ease out
+    {-2.f, 3.f, 0.f},//ease in out
+};
+
+AnimationPool::AnimationPool (size_t capacity) {
+    std::vector<float>* floats[] = {&fromX, &fromY, &fromZ, &toX, &toY, &toZ,
+                                    &tanFromX, &tanFromY, &tanFromZ, &tanToX, &tanToY, &tanToZ,
+                                    &durations, &invDurations, &easeA, &easeB, &easeC,
+                                    &progress, &eased, &outX, &outY, &outZ};
+    for (std::vector<float>* v : floats)
+        v->resize(capacity);
+    starts.resize(capacity);
+    targets.resize(capacity);
+}
+
+float AnimationPool::ease (Easing easing, float t) {
+    const float* e = easeCoefs[(int)easing];
+    return ((e[0] * t + e[1]) * t + e[2]) * t;
+}
+
+int AnimationPool::last (uint32_t target) const {
+    int found = -1;
+    for (size_t i = 0; i < count; i++)
+        if (targets[i] == target &&
+                (found < 0 || starts[i] + durations[i] > starts[found] + durations[found]))
+            found = (int)i;
+    return found;
+}
+
+bool AnimationPool::add (uint32_t target, const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2,
+                         const glm::vec3& p3, double now, float duration, Easing easing) {
+    if (count == capacity())
+        return false;
+    int previous = last(target);
+    size_t i = count++;
+    //catmull-rom tangents are half the vectors between the neighbours of each end
+    fromX[i]    = p1.x;
+    fromY[i]    = p1.y;
+    fromZ[i]    = p1.z;
+    toX[i]      = p2.x;
+    toY[i]      = p2.y;
+    toZ[i]      = p2.z;
+    tanFromX[i] = (p2.x - p0.x) * 0.5f;
+    tanFromY[i] = (p2.y - p0.y) * 0.5f;
+    tanFromZ[i] = (p2.z - p0.z) * 0.5f;
+    tanToX[i]   = (p3.x - p1.x) * 0.5f;
+    tanToY[i]   = (p3.y - p1.y) * 0.5f;
+    tanToZ[i]   = (p3.z - p1.z) * 0.5f;
+    starts[i]   = previous < 0 ? now : std::max(now, starts[previous] + durations[previous]);
+    durations[i] = duration;
+    invDurations[i] = 1.f / std::max(duration, 1e-6f);
+    targets[i]  = target;
+    easeA[i]    = easeCoefs[(int)easing][0];
+    easeB[i]    = easeCoefs[(int)easing][1];
+    easeC[i]    = easeCoefs[(int)easing][2];
+    return true;
+}
+
+void AnimationPool::remove (size_t i) {
+    size_t l = --count;
+    fromX[i]    = fromX[l];
+    fromY[i]    = fromY[l];
+    fromZ[i]    = fromZ[l];
+    toX[i]      = toX[l];
+    toY[i]      = toY[l];
+    toZ[i]      = toZ[l];
+    tanFromX[i] = tanFromX[l];
+    tanFromY[i] = tanFromY[l];
+    tanFromZ[i] = tanFromZ[l];
+    tanToX[i]   = tanToX[l];
+    tanToY[i]   = tanToY[l];
+    tanToZ[i]   = tanToZ[l];
+    starts[i]   = starts[l];
+    durations[i] = durations[l];
+    invDurations[i] = invDurations[l];
+    targets[i]  = targets[l];
+    easeA[i]    = easeA[l];
+    easeB[i]    = easeB[l];
+    easeC[i]    = easeC[l];
+    progress[i] = progress[l];
+    eased[i]    = eased[l];
+    outX[i]     = outX[l];
+    outY[i]     = outY[l];
+    outZ[i]     = outZ[l];
+}
+
+void AnimationPool::cancel (uint32_t target) {
+    size_t i = 0;
+    while (i < count) {
+        if (targets[i] == target)
+            remove(i);
+        else
+            i++;
+    }
+}
+
+void AnimationPool::retarget (uint32_t target, uint32_t to) {
+    for (size_t i = 0; i < count; i++)
+        if (targets[i] == target)
+            targets[i] = to;
+}
+
+glm::vec3 AnimationPool::finalPosition (uint32_t target, const glm::vec3& current) const {
+    int i = last(target);
+    return i < 0 ? current : glm::vec3(toX[i], toY[i], toZ[i]);
+}
+
+void AnimationPool::evaluate (double now) {
+    //both loops are branch free over plain arrays, so they are vectorized
+    const double* __restrict st = starts.data();
+    const float* __restrict inv = invDurations.data();
+    const float* __restrict ea  = easeA.data();
+    const float* __restrict eb  = easeB.data();
+    const float* __restrict ec  = easeC.data();
+    float* __restrict p = progress.data();
+    float* __restrict e = eased.data();
+    for (size_t i = 0; i < count; i++) {
+        float t = (float)(now - st[i]) * inv[i];
+        p[i] = t < 0.f ? -1.f : std::min(t, 1.f);
+        t = std::min(std::max(t, 0.f), 1.f);
+        e[i] = ((ea[i] * t + eb[i]) * t + ec[i]) * t;
+    }
+
+    const float* __restrict s   = eased.data();
+    const float* __restrict fx  = fromX.data();
+    const float* __restrict fy  = fromY.data();
+    const float* __restrict fz  = fromZ.data();
+    const float* __restrict tx  = toX.data();
+    const float* __restrict ty  = toY.data();
+    const float* __restrict tz  = toZ.data();
+    const float* __restrict mfx = tanFromX.data();
+    const float* __restrict mfy = tanFromY.data();
+    const float* __restrict mfz = tanFromZ.data();
+    const float* __restrict mtx = tanToX.data();
+    const float* __restrict mty = tanToY.data();
+    const float* __restrict mtz = tanToZ.data();
+    float* __restrict ox = outX.data();
+    float* __restrict oy = outY.data();
+    float* __restrict oz = outZ.data();
+    for (size_t i = 0; i < count; i++) {
+        float s2 = s[i] * s[i], s3 = s2 * s[i];
+        float h00 = 2.f * s3 - 3.f * s2 + 1.f;
+        float h10 = s3 - 2.f * s2 + s[i];
+        float h01 = 3.f * s2 - 2.f * s3;
+        float h11 = s3 - s2;
+        ox[i] = h00 * fx[i] + h10 * mfx[i] + h01 * tx[i] + h11 * mtx[i];
+        oy[i] = h00 * fy[i] + h10 * mfy[i] + h01 * ty[i] + h11 * mty[i];
+        oz[i] = h00 * fz[i] + h10 * mfz[i] + h01 * tz[i] + h11 * mtz[i];
+    }
+}
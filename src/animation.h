@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+//progress of an animation along its curve over its duration
+enum class Easing : uint8_t { Linear, EaseIn, EaseOut, EaseInOut };
+
+//Running and queued animations stored as structure of arrays. Each one is a
+//catmull-rom segment kept in hermite form: start and end points with their
+//tangents, one array per component. Positions are evaluated from the clock each
+//frame in branch free loops over all animations at once, that the compiler
+//vectorizes, so the speed does not depend on the frame rate. Storage is sized
+//once, finished animations are replaced by the last one, so playing animations
+//never allocates. An animation added for a target still moving starts when the
+//previous one ends.
+class AnimationPool {
+public:
+    explicit AnimationPool (size_t capacity = 256);
+
+    //queue a move of target along the catmull-rom segment p1 to p2, at now or
+    //after its last queued animation. False if the pool is full.
+    bool        add (uint32_t target, const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2,
+                     const glm::vec3& p3, double now, float duration, Easing easing = Easing::EaseInOut);
+    //drop the animations of target, it stays where it is
+    void        cancel (uint32_t target);
+    //animations of target go on moving to instead
+    void        retarget (uint32_t target, uint32_t to);
+    void        clear ()            { count = 0; }
+    size_t      size () const       { return count; }
+    size_t      capacity () const   { return targets.size(); }
+    //where target will be once its queued animations are done, current if none
+    glm::vec3   finalPosition (uint32_t target, const glm::vec3& current) const;
+
+    static float ease (Easing easing, float t);
+
+    //compute the positions of all animations at now, without applying them
+    void        evaluate (double now);
+    //evaluate, then call apply(target, position) for each started animation,
+    //finished ones get their end point and are removed
+    template <typename Apply>
+    void update (double now, Apply apply) {
+        evaluate(now);
+        size_t i = 0;
+        while (i < count) {
+            if (progress[i] < 0.f) {
+                i++;
+                continue;
+            }
+            apply(targets[i], glm::vec3(outX[i], outY[i], outZ[i]));
+            if (progress[i] >= 1.f)
+                remove(i);
+            else
+                i++;
+        }
+    }
+
+private:
+    size_t                  count = 0;
+    //hermite form of the segments, per component
+    std::vector<float>      fromX, fromY, fromZ;
+    std::vector<float>      toX, toY, toZ;
+    std::vector<float>      tanFromX, tanFromY, tanFromZ;
+    std::vector<float>      tanToX, tanToY, tanToZ;
+    std::vector<double>     starts;//seconds on the caller clock
+    std::vector<float>      durations, invDurations;
+    std::vector<uint32_t>   targets;
+    std::vector<float>      easeA, easeB, easeC;//easing polynomial, see ease()
+    //evaluate() results: raw progress, -1 if not started yet, and positions
+    std::vector<float>      progress, eased;
+    std::vector<float>      outX, outY, outZ;
+
+    //index of the animation of target ending last, -1 if none
+    int         last (uint32_t target) const;
+    //move the last animation to i
+    void        remove (size_t i);
+};
@@ -0,0 +1,150 @@
+#include "bitboard.h"
+
+namespace chess {
+
+Bitboard pawnAttacks[2][64];
+Bitboard knightAttacks[64];
+Bitboard kingAttacks[64];
+Bitboard betweenBB[64][64];
+Bitboard lineBB[64][64];
+
+Magic    rookMagics[64];
+Magic    bishopMagics[64];
+
+namespace Zobrist {
+    uint64_t psq[2][6][64];
+    uint64_t side;
+    uint64_t castling[16];
+    uint64_t epFile[8];
+}
+
+static Bitboard rookTable[0x19000];
+static Bitboard bishopTable[0x1480];
+
+static const int rookDirs[4][2]   = {{0,1},{0,-1},{1,0},{-1,0}};
+static const int bishopDirs[4][2] = {{1,1},{-1,-1},{1,-1},{-1,1}};
+
+static Bitboard stepAttack (int sq, int dx, int dy) {
+    int x = fileOf(sq) + dx;
+    int y = rankOf(sq) + dy;
+    if (x < 0 || x > 7 || y < 0 || y > 7)
+        return 0;
+    return bit(square(x,y));
+}
+//slow ray walk, only used to build the tables
+static Bitboard slidingAttack (const int dirs[4][2], int sq, Bitboard occ) {
+    Bitboard attacks = 0;
+    for (int d=0; d<4; d++) {
+        int x = fileOf(sq) + dirs[d][0];
+        int y = rankOf(sq) + dirs[d][1];
+        while (x >= 0 && x < 8 && y >= 0 && y < 8) {
+            attacks |= bit(square(x,y));
+            if (occ & bit(square(x,y)))
+                break;
+            x += dirs[d][0];
+            y += dirs[d][1];
+        }
+    }
+    return attacks;
+}
+
+static uint64_t rndState = 0x2545F4914F6CDD1DULL;
+static uint64_t rnd64 () {
+    rndState ^= rndState >> 12;
+    rndState ^= rndState << 25;
+    rndState ^= rndState >> 27;
+    return rndState * 2685821657736338717ULL;
+}
+
+//search a magic multiplier for each square by trial and error with sparse random numbers
+static void initMagics (Magic magics[64], Bitboard* table, const int dirs[4][2]) {
+    Bitboard occupancy[4096], reference[4096];
+    int      epoch[4096] = {}, attempt = 0;
+
+    for (int sq=0; sq<64; sq++) {
+        //board edges are not relevant for occupancy, except along the slider's own rank or file
+        Bitboard edges = ((Rank1 | Rank8) & ~(rankOf(sq) == 0 ? Rank1 : rankOf(sq) == 7 ? Rank8 : 0)) |
+                         ((FileA | FileH) & ~(fileOf(sq) == 0 ? FileA : fileOf(sq) == 7 ? FileH : 0));
+        Magic& m    = magics[sq];
+        m.mask      = slidingAttack(dirs, sq, 0) & ~edges;
+        m.shift     = 64 - popCount(m.mask);
+        m.attacks   = (sq == 0) ? table : magics[sq-1].attacks + (1 << (64 - magics[sq-1].shift));
+
+        //carry-rippler enumeration of all mask subsets
+        int size = 0;
+        Bitboard b = 0;
+        do {
+            occupancy[size] = b;
+            reference[size++] = slidingAttack(dirs, sq, b);
+            b = (b - m.mask) & m.mask;
+        } while (b);
+
+        for (int i=0; i<size; ) {
+            do
+                m.magic = rnd64() & rnd64() & rnd64();
+            while (popCount((m.magic * m.mask) >> 56) < 6);
+
+            attempt++;
+            for (i=0; i<size; i++) {
+                uint32_t idx = m.index(occupancy[i]);
+                if (epoch[idx] < attempt) {
+                    epoch[idx] = attempt;
+                    m.attacks[idx] = reference[i];
+                } else if (m.attacks[idx] != reference[i])
+                    break;
+            }
+        }
+    }
+}
+
+void initBitboards () {
+    static bool initialized = false;
+    if (initialized)
+        return;
+
+    const int knightSteps[8][2] = {{2,1},{2,-1},{-2,1},{-2,-1},{1,2},{-1,2},{1,-2},{-1,-2}};
+    const int kingSteps[8][2]   = {{-1,-1},{-1,0},{-1,1},{0,-1},{0,1},{1,-1},{1,0},{1,1}};
+
+    for (int sq=0; sq<64; sq++) {
+        pawnAttacks[White][sq] = stepAttack(sq,-1, 1) | stepAttack(sq, 1, 1);
+        pawnAttacks[Black][sq] = stepAttack(sq,-1,-1) | stepAttack(sq, 1,-1);
+        knightAttacks[sq] = kingAttacks[sq] = 0;
+        for (int i=0; i<8; i++) {
+            knightAttacks[sq]   |= stepAttack(sq, knightSteps[i][0], knightSteps[i][1]);
+            kingAttacks[sq]     |= stepAttack(sq, kingSteps[i][0], kingSteps[i][1]);
+        }
+    }
+
+    initMagics (rookMagics, rookTable, rookDirs);
+    initMagics (bishopMagics, bishopTable, bishopDirs);
+
+    rndState = 0x9E3779B97F4A7C15ULL;//fixed seed, keys are the same on every run
+    for (int c=0; c<2; c++)
+        for (int t=0; t<6; t++)
+            for (int sq=0; sq<64; sq++)
+                Zobrist::psq[c][t][sq] = rnd64();
+    Zobrist::side = rnd64();
+    for (int i=0; i<16; i++)
+        Zobrist::castling[i] = rnd64();
+    for (int i=0; i<8; i++)
+        Zobrist::epFile[i] = rnd64();
+
+    for (int a=0; a<64; a++) {
+        for (int b=0; b<64; b++) {
+            betweenBB[a][b] = lineBB[a][b] = 0;
+            if (a == b)
+                continue;
+            if (rookAttacks(a, 0) & bit(b)) {
+                betweenBB[a][b] = rookAttacks(a, bit(b)) & rookAttacks(b, bit(a));
+                lineBB[a][b]    = (rookAttacks(a, 0) & rookAttacks(b, 0)) | bit(a) | bit(b);
+            } else if (bishopAttacks(a, 0) & bit(b)) {
+                betweenBB[a][b] = bishopAttacks(a, bit(b)) & bishopAttacks(b, bit(a));
+                lineBB[a][b]    = (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | bit(a) | bit(b);
+            }
+        }
+    }
+
+    initialized = true;
+}
+
+}
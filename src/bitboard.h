@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stdint.h>
+
+//64 bits board representation, square index is y*8+x with a1=0 and h8=63,
+//which match the (x,y) case coordinates used by VkChess::board.
+namespace chess {
+
+typedef uint64_t Bitboard;
+
+enum Color      { White, Black };
+//same order as VkChess::PceType so types may be casted from one to the other
+enum PceType    { Pawn, Rook, Knight, Bishop, Queen, King, NoPce };
+
+enum Square {
+    A1 = 0, B1, C1, D1, E1, F1, G1, H1,
+    A8 = 56, B8, C8, D8, E8, F8, G8, H8,
+    NoSquare = -1
+};
+
+const Bitboard Rank1 = 0xFFULL;
+const Bitboard Rank8 = Rank1 << 56;
+const Bitboard FileA = 0x0101010101010101ULL;
+const Bitboard FileH = FileA << 7;
+
+inline int square (int x, int y)    { return y * 8 + x; }
+inline int fileOf (int sq)          { return sq & 7; }
+inline int rankOf (int sq)          { return sq >> 3; }
+inline Bitboard bit (int sq)        { return 1ULL << sq; }
+inline Color operator~ (Color c)    { return (Color)(c ^ 1); }
+
+inline int lsb (Bitboard b)         { return __builtin_ctzll(b); }
+inline int popCount (Bitboard b)    { return __builtin_popcountll(b); }
+inline int popLsb (Bitboard& b) {
+    int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+//fancy magic bitboard entry for one square
+struct Magic {
+    Bitboard    mask;
+    Bitboard    magic;
+    Bitboard*   attacks;
+    uint32_t    shift;
+
+    inline uint32_t index (Bitboard occ) const {
+        return (uint32_t)(((occ & mask) * magic) >> shift);
+    }
+};
+
+extern Bitboard pawnAttacks[2][64];
+extern Bitboard knightAttacks[64];
+extern Bitboard kingAttacks[64];
+extern Bitboard betweenBB[64][64];//squares strictly between two aligned squares
+extern Bitboard lineBB[64][64];//full line through two aligned squares
+
+extern Magic    rookMagics[64];
+extern Magic    bishopMagics[64];
+
+//random keys xored together to build the 64 bits position hash
+namespace Zobrist {
+    extern uint64_t psq[2][6][64];
+    extern uint64_t side;
+    extern uint64_t castling[16];
+    extern uint64_t epFile[8];
+}
+
+inline Bitboard rookAttacks (int sq, Bitboard occ) {
+    return rookMagics[sq].attacks[rookMagics[sq].index(occ)];
+}
+inline Bitboard bishopAttacks (int sq, Bitboard occ) {
+    return bishopMagics[sq].attacks[bishopMagics[sq].index(occ)];
+}
+inline Bitboard queenAttacks (int sq, Bitboard occ) {
+    return rookAttacks(sq, occ) | bishopAttacks(sq, occ);
+}
+
+//attack tables are filled once at startup, calling it again is a no-op
+void initBitboards ();
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <stdint.h>
+#include <random>
+
+#include "position.h"
+#include "pgn.h"
+
+//Polyglot opening book, looked up in place by binary search over the memory
+//mapped .bin file, so nothing is loaded whatever the book size. Polyglot keys
+//use their own 781 random numbers, unrelated to our zobrist keys.
+class OpeningBook {
+public:
+    //false if the file can not be read or the polyglot key of the start
+    //position is wrong, the book stays closed then
+    bool    open (const char* bookPath);
+    void    close ();
+    bool    isOpen () const     { return entries != nullptr; }
+
+    uint64_t    polyglotKey (const chess::Position& pos) const;
+    //legal book move for pos picked at random in proportion of the entry
+    //weights, NoMove when out of book
+    chess::Move probe (const chess::Position& pos);
+
+private:
+    MappedFile      file;
+    const uint8_t*  entries = nullptr;//16 bytes each, sorted by key
+    size_t          count   = 0;
+    std::mt19937    rng{std::random_device()()};
+};
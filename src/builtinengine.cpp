@@ -0,0 +1,155 @@
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+
+#include "builtinengine.h"
+#include "fakeuci.h"
+
+BuiltinEngine::BuiltinEngine (SpscQueue<UciMessage, 1024>& output) : output(output) {
+    thread = std::thread(&BuiltinEngine::run, this);
+}
+BuiltinEngine::~BuiltinEngine () {
+    receive("quit");
+    thread.join();
+}
+
+void BuiltinEngine::receive (const std::string& cmd) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cmd == "stop") {
+        //also stops the searches still queued
+        stoppedSearches = queuedSearches;
+        searcher.stop = true;
+    } else if (cmd == "ponderhit") {
+        ponderedSearches = queuedSearches;
+        searcher.ponderhit = true;
+    } else if (cmd == "quit") {
+        searcher.stop = true;
+        quit = true;
+    } else {
+        if (cmd.compare(0, 2, "go") == 0)
+            queuedSearches++;
+        commands.push_back(cmd);
+    }
+    wake.notify_one();
+}
+
+void BuiltinEngine::run () {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return quit || !commands.empty(); });
+        if (quit)
+            return;
+        std::istringstream in(commands.front());
+        commands.pop_front();
+        std::string cmd;
+        in >> cmd;
+        if (cmd == "go") {
+            searcher.stop       = stoppedSearches > startedSearches;
+            searcher.ponderhit  = ponderedSearches > startedSearches;
+            startedSearches++;
+        }
+        lock.unlock();
+
+        if (cmd == "uci") {
+            post("id name vkChess builtin");
+            post("uciok");
+        } else if (cmd == "isready")
+            post("readyok");
+        else if (cmd == "ucinewgame") {
+            searcher.clear();
+            position.setStartPosition();
+            history.clear();
+        } else if (cmd == "setoption") {
+            std::string tok, name;
+            while (in >> tok && tok != "value")
+                if (tok != "name")
+                    name += tok;
+            if (name == "SkillLevel")
+                in >> skillLevel;
+        } else if (cmd == "position")
+            chess::readUciPosition(position, in, &history);
+        else if (cmd == "go")
+            go(in);
+
+        lock.lock();
+    }
+}
+
+void BuiltinEngine::go (std::istringstream& in) {
+    chess::SearchLimits limits;
+    bool infinite = true;
+    int time[2] = {0, 0}, inc[2] = {0, 0}, movesToGo = 30;
+    std::string tok;
+    while (in >> tok) {
+        if (tok == "movetime")
+            in >> limits.movetime;
+        else if (tok == "depth")
+            in >> limits.depth;
+        else if (tok == "nodes")
+            in >> limits.nodes;
+        else if (tok == "wtime")
+            in >> time[chess::White];
+        else if (tok == "btime")
+            in >> time[chess::Black];
+        else if (tok == "winc")
+            in >> inc[chess::White];
+        else if (tok == "binc")
+            in >> inc[chess::Black];
+        else if (tok == "movestogo")
+            in >> movesToGo;
+        else if (tok == "ponder") {
+            limits.ponder = true;
+            continue;
+        } else
+            continue;
+        infinite = false;
+    }
+    if (time[position.side])
+        limits.movetime = time[position.side] / std::max(movesToGo, 1) + inc[position.side] / 2;
+    if (skillLevel < 20)
+        limits.depth = std::min(limits.depth, 1 + skillLevel / 4);
+
+    chess::SearchInfo info;
+    chess::Move best = searcher.search(position, history, limits, info, [this] (const chess::SearchInfo& i) {
+        std::string line = "info depth " + std::to_string(i.depth) + " seldepth " + std::to_string(i.seldepth);
+        if (chess::isMateScore(i.score))
+            line += " score mate " + std::to_string(i.score > 0 ? (chess::MateScore - i.score + 1) / 2
+                                                                : -(chess::MateScore + i.score) / 2);
+        else
+            line += " score cp " + std::to_string(i.score);
+        line += " nodes " + std::to_string(i.nodes) + " time " + std::to_string(i.time) + " pv";
+        for (int p = 0; p < i.pvLength; p++)
+            line += " " + chess::moveToUci(i.pv[p]);
+        post(line);
+    });
+
+    //uci forbids answering an infinite search before stop, or a ponder search before ponderhit
+    if (infinite || limits.ponder) {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return quit || searcher.stop || (!infinite && searcher.ponderhit); });
+    }
+    if (best == chess::NoMove) {
+        post(std::string("info depth 0 score ") + (position.inCheck() ? "mate 0" : "cp 0"));
+        post("bestmove (none)");
+    } else if (info.pvLength > 1)
+        post("bestmove " + chess::moveToUci(best) + " ponder " + chess::moveToUci(info.pv[1]));
+    else
+        post("bestmove " + chess::moveToUci(best));
+}
+
+void BuiltinEngine::post (const std::string& line) {
+#if DEBUG_STOCKFISH
+    std::cout << "=> " << line << std::endl;
+#endif
+    UciMessage msg;
+    if (!parseUciLine(line.c_str(), line.length(), msg))
+        return;
+    msg.line    = nullptr;
+    msg.length  = 0;
+    if (msg.type == UciMessage::Info) {
+        output.push(msg);//dropped when full as with a process, a newer one follows
+        return;
+    }
+    while (!quit && !output.push(msg))
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
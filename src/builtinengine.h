@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <sstream>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "ucisession.h"
+#include "ucireader.h"
+#include "spscqueue.h"
+#include "search.h"
+
+//Uci engine running the in process Searcher on its own thread, the fallback when
+//no external engine can be started. Commands come from a UciSession through its
+//sink and replies are posted already parsed to the queue an EngineThread would
+//fill, so the game and the pool drive it like an engine process without pipes.
+//Skill levels below 20 limit the search depth.
+class BuiltinEngine : public UciSink {
+public:
+    explicit BuiltinEngine (SpscQueue<UciMessage, 1024>& output);
+    ~BuiltinEngine ();
+
+    //called from the session thread, stop, ponderhit and quit reach the running search at once
+    void receive (const std::string& cmd);
+
+private:
+    SpscQueue<UciMessage, 1024>&    output;
+    chess::Searcher         searcher;
+    std::thread             thread;
+    std::mutex              mutex;
+    std::condition_variable wake;
+    std::deque<std::string> commands;
+    std::atomic<bool>       quit{false};
+    //go commands received and started, a stop or a ponderhit applies to every search received before it
+    uint64_t                queuedSearches  = 0;
+    uint64_t                startedSearches = 0;
+    uint64_t                stoppedSearches = 0;
+    uint64_t                ponderedSearches = 0;
+
+    chess::Position         position;
+    std::vector<uint64_t>   history;//keys of the positions before position
+    int                     skillLevel  = 20;
+
+    void run ();
+    void go (std::istringstream& in);
+    void post (const std::string& line);
+};
@@ -20,7 +20,9 @@
 #include <fcntl.h>
 #include <assert.h>
 #include <vector>
+#include <algorithm>
 #include <chrono>
+#include <thread>
 #include <list>
 #include <iostream>
 #include <errno.h>
@@ -36,9 +38,19 @@
 
 #include "vkvg.h"
 
+#include "position.h"
+#include "perft.h"
+#include "parallelperft.h"
+#include "ucisession.h"
+#include "chessgame.h"
+#include "fakeuci.h"
+#include "headless.h"
+#include "analysis.h"
+#include "animation.h"
+
 #define CAPTURE_ZONE_HEIGHT 5
 
-class VkChess : public vks::VkEngine
+class VkChess : public vks::VkEngine, public GameObserver
 {
 public:
     enum Color { White, Black };
@@ -53,9 +65,9 @@ public:
         glm::ivec2  initPosition;
         float       yAngle;
         bool        captured;
-        bool        hasMoved;
 
-        uint32_t    instance;
+        uint32_t    instance;//the one shown, a spare queen for a promoted pawn that has it
+        uint32_t    pawnInstance;
 
         glm::vec3 getCurrentPosition(vkglTF::Model* mod) {
             glm::vec3 scale;
@@ -67,10 +79,6 @@ public:
             return translation;
         }
     };
-    struct animation{
-        uint32_t uboIdx;
-        std::queue<glm::mat4> queue;
-    };
 
     //vks::vkRenderer*     debugRenderer = nullptr;
     pbrRenderer*   sceneRenderer = nullptr;
@@ -100,6 +108,15 @@ public:
     {
         vkDeviceWaitIdle        (device->dev);
 
+#if DEBUG_STOCKFISH
+        for (size_t i=0; i<engines.size(); i++)
+            std::cout << "uci " << i << ": " << engines[i].session.commandsSent << " commands, "
+                      << engines[i].session.bytesSent << " bytes sent (about "
+                      << engines[i].session.fullGameBytes << " bytes resending full games), "
+                      << engines[i].reader.droppedInfos << " info lines dropped" << std::endl;
+#endif
+        engines.stop();
+
         for (uint i=0; i<2; i++)
             for (uint j=0; j<6; j++)
                 vkvg_surface_destroy(piecesImgs[i][j]);
@@ -117,18 +134,25 @@ public:
     const glm::vec4 bestMoveColor   = glm::vec4(0.0,0.2,0.0,1.0);
     const glm::vec4 checkColor      = glm::vec4(0.6,0.0,0.0,1.0);
 
-    Color currentPlayer = White;
-    bool gameStarted    = false;
-    bool playerIsAi[2]  = {false,true};
-    bool playerWin[2]   = {false,false};
+    ChessGame game;//rules, history and engines, board[][] follows it as observer
     Piece pieces[32];
     Piece* board[8][8]  = {};
 
     int cptWhiteOut = 0;
     int cptBlackOut = 0;
 
-    int animSteps = 150;
-    std::vector <animation> animations;
+    AnimationPool animations;
+    float animDuration = 0.5f;//seconds per piece move
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    //instances were flagged on the model since its last buffer update
+    bool instancesDirty = false;
+    //instance buffer updates, to check idle frames send nothing
+    struct {
+        uint64_t frames         = 0;
+        uint64_t uploadFrames   = 0;//frames where the model buffer was updated
+        uint64_t flags          = 0;//instance changes flagged on the model
+    } uploadStats;
 
     glm::ivec2 bestMoveOrig     = glm::ivec2(-1,-1);
     glm::ivec2 bestMoveTarget   = glm::ivec2(-1,-1);
@@ -137,20 +161,13 @@ public:
     glm::ivec2 selectedSquare   = glm::ivec2(-1,-1);
 
     //stockfish
-    bool stockFishIsReady   = false;
-    bool hint               = false;
-    uint8_t level[2]        = {20,0};
-    char* nextCommand;
-    int sfPid, sfReadfd, sfWritefd;
-
-    char sfOutBuff[1024];
-    int sfOutBuffPtr        = 0;
-
-    std::string sfcmdGo = "go movetime 50\n";
-    const char* initPosCmd = "position startpos moves ";
-    char movesBuffer[40000];
-    int previouMovesPtr;
-    int movesPtr;
+    EnginePool engines;
+    std::string engineCommand = "stockfish";
+    //engine replies by position, shared by all games of the session
+    ReplyCache replyCache;
+    OpeningBook book;
+    //messages handled per frame at most, the rest waits for the next frame
+    const int maxEngineMessagesPerFrame = 64;
 
     float angle = 0.f;
 
@@ -183,12 +200,16 @@ public:
         VkvgContext ctx = vkvg_create(surf);
 
         std::string msg;
-        if (playerWin[White])
+        if (game.winner() == White)
             msg = "Whites win";
-        else if (playerWin[Black])
+        else if (game.winner() == Black)
             msg = "Blacks win";
-        else
+        else if (game.termination == chess::Stalemate)
             msg = "Pad";
+        else if (game.failed)
+            msg = "Engine error";
+        else
+            msg = "Draw";
 
         vkvg_move_to(ctx,x+5,y+5);
         vkvg_set_font_size(ctx,120);
@@ -200,6 +221,14 @@ public:
         vkvg_set_source_rgba (ctx, 1,1,1,1);
         vkvg_show_text(ctx, msg.c_str());
 
+        vkvg_move_to(ctx,x+5,y+85);
+        vkvg_set_font_size(ctx,40);
+        vkvg_set_source_rgba (ctx, 0,0,0,1);
+        vkvg_show_text(ctx, chess::terminationName(game.termination));
+        vkvg_move_to(ctx,x,y+80);
+        vkvg_set_source_rgba (ctx, 1,1,1,1);
+        vkvg_show_text(ctx, chess::terminationName(game.termination));
+
         vkvg_destroy (ctx);
     }
     void vkvg_print_fps() {
@@ -284,22 +313,18 @@ public:
         angle+=0.0005f;
     }
     void update(){
-        readStockfishLine();
-
-        std::vector<animation>::iterator itr = animations.begin();
-        for ( ; itr != animations.end(); ) {
-            if (itr->queue.empty()) {
-                itr = animations.erase(itr);
-            } else {
-                glm::mat4 a = itr->queue.front();
-                itr->queue.pop();
-                mod->instanceDatas[itr->uboIdx].modelMat = a;
-                mod->setInstanceIsDirty(itr->uboIdx);
-                ++itr;
-            }
-        }
+        game.poll(maxEngineMessagesPerFrame);
 
-        mod->updateInstancesBuffer();
+        animations.update (animClock(), [this](uint32_t instance, const glm::vec3& pos) {
+            mod->instanceDatas[instance].modelMat = glm::translate (glm::mat4(1.0), pos);
+            setInstanceIsDirty(instance);
+        });
+
+        if (drawsChanged) {
+            rebuildCommandBuffers();
+            drawsChanged = false;
+        }
+        uploadInstances();
 
         //updateMiniBoard();
         vkvg_print_fps();
@@ -307,240 +332,52 @@ public:
         //vkvg_test();
     }
 
-    Piece* getPiece (glm::ivec2 pos){
-        return board[pos.x][pos.y];
-    }
-
-    void animatePce (uint32_t pceIdx, float x, float y) {
-        glm::vec3 vUp = glm::vec3(0.f,-10.f,0.f);
-        glm::vec3 start = glm::vec3(mod->instanceDatas[pceIdx].modelMat[3]);
-        glm::vec3 end   = glm::vec3(x*2 - 7, 0.f, 7 - y*2);
-
-        animation a;
-        a.uboIdx = pceIdx;
-        animSteps = std::max(lastFPS/2, 60u);
-
-        for (int i = 0; i<=animSteps; i++){
-            float t = (float)i / (float)animSteps;
-            a.queue.push (glm::translate (glm::mat4(1.0), glm::catmullRom (start+vUp, start, end, end+vUp, t)));
-        }
-        animations.push_back(a);
-    }
-    void toogleHint() {
-        hint = !hint;
-
-        clearBestMove();
-
-        if (playerIsAi[currentPlayer])
-            return;
-        if (hint) {
-            sendPositionsCmd();
-            write(sfWritefd,"go infinite\n", 12);
-        }else{
-            write(sfWritefd,"stop\n",5);
-        }
+    void setInstanceIsDirty (uint32_t instance) {
+        mod->setInstanceIsDirty(instance);
+        instancesDirty = true;
+        uploadStats.flags++;
     }
-
-    void sendPositionsCmd (){
-        if (movesPtr==0)
+    //the model buffer update is skipped on frames without changes
+    void uploadInstances () {
+        uploadStats.frames++;
+        if (!instancesDirty)
             return;
-        char levelBuf[100];
-        std::stringstream out;
-        out << "setoption name Skill Level value " << std::to_string(level[currentPlayer]) << std::endl;
-        out << std::string(movesBuffer, movesPtr-1) << std::endl;
-        //out << sfcmdGo;
-        //sprintf (levelBuf,"setoption name Skill Level value %d\n",level[currentPlayer]);
-        //write(sfWritefd, levelBuf, strlen(levelBuf));
-        //write(sfWritefd, movesBuffer, movesPtr-1 );
-        //write(sfWritefd, "\n", 1 );
-        //write(sfWritefd, sfcmdGo.c_str() , sfcmdGo.length());
-
-#if DEBUG_STOCKFISH
-        std::cout << std::to_string(sfWritefd) << " <= " << out.str();
-#endif
-
-        write(sfWritefd, out.str().c_str(), out.tellp());
-
+        mod->updateInstancesBuffer();
+        instancesDirty = false;
+        uploadStats.uploadFrames++;
     }
 
-    char* getBestMove() {
-        getStockFishIsReady();
-        sendPositionsCmd();
-        write(sfWritefd, sfcmdGo.c_str() , sfcmdGo.length());
+    Piece* getPiece (glm::ivec2 pos){
+        return board[pos.x][pos.y];
     }
 
-    bool getStockFishIsReady () {
-        write(sfWritefd,"isready\n",8);
-        char buff[8];
-        read(sfReadfd, buff, 8);
-        if (strncmp(buff, "readyok\n", 8)==0)
-            return true;
-        else
-            return false;
-    }
-    void getStockFishOutput () {
-        int saved_flags = fcntl(sfReadfd, F_GETFL);
-        char c;
-        bool blockingRead = true;
-        while (read (sfReadfd, &c, 1)==1){
-            if (blockingRead){
-                fcntl(sfReadfd, F_SETFL, O_NONBLOCK);//set pipe non blocking
-                blockingRead = false;
-            }
-            sfOutBuff[sfOutBuffPtr++] = c;
-        }
-        sfOutBuff[sfOutBuffPtr] = 0;
-        //std::cout << sfOutBuff << std::endl;
-        sfOutBuffPtr = 0;
-        fcntl(sfReadfd, F_SETFL, saved_flags & ~O_NONBLOCK);//set pipe blocking
+    //seconds since startup, animations are evaluated on this clock
+    double animClock () const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
     }
+    void animatePce (uint32_t pceIdx, float x, float y) {
+        glm::vec3 vUp = glm::vec3(0.f,-10.f,0.f);
+        //a piece still moving leaves from where its queued moves end
+        glm::vec3 start = animations.finalPosition (pceIdx, glm::vec3(mod->instanceDatas[pceIdx].modelMat[3]));
+        glm::vec3 end   = glm::vec3(x*2 - 7, 0.f, 7 - y*2);
 
-    int skipnspace(char* buff, int numSpaces){
-        int ptr=0;
-        for (int i=0; i<numSpaces; i++){
-            while (buff[ptr++]!=0x20)
-                continue;
-        }
-        return ptr;
-    }
-    void readStockfishLine () {
-        char c = 0;
-        char lineBuf[1024];
-        int ptr = 0;
-        if (read (sfReadfd, &c, 1)!=1)
+        if (animations.add (pceIdx, start+vUp, start, end, end+vUp, animClock(), animDuration))
             return;
-        lineBuf[ptr++] = c;
-        stockFishIsReady = false;
-        while (c!='\n'){
-            if (read (sfReadfd, &c, 1)==1)
-                lineBuf[ptr++] = c;
-        }
-        lineBuf[ptr] = 0;
-
-#if DEBUG_STOCKFISH
-      std::cout << "=> " << lineBuf;
-      std::flush(std::cout);
-#endif
-        if (strncmp (lineBuf, "readyok", 7)==0){
-            stockFishIsReady = true;
-            if (!gameStarted && playerIsAi[currentPlayer]) {
-                gameStarted = true;
-                startTurn();
-            }
-        }else if (strncmp (lineBuf, "uciok", 5)==0){
-
-        }else if (strncmp (lineBuf, "info", 4)==0){
-            if (playerIsAi[currentPlayer] || !hint)
-                return;
-            ptr=5;
-            ptr+=skipnspace(lineBuf+ptr,2);
-            if (strncmp(lineBuf+ptr, "seldepth", 8)!=0)
-                return;
-            ptr+=9;
-            while (strncmp(lineBuf+ptr, " pv ", 4)!=0)
-                ptr++;
-            ptr+=4;
-
-            if (bestMoveOrig.x >=0){
-                subCaseLight(bestMoveOrig, bestMoveColor);
-                subCaseLight(bestMoveTarget, bestMoveColor);
-            }
-            bestMoveOrig = glm::ivec2(lineBuf[ptr]-97, lineBuf[ptr+1]-49);
-            bestMoveTarget = glm::ivec2(lineBuf[ptr+2]-97, lineBuf[ptr+3]-49);
-            if (bestMoveOrig.x >=0){
-                addCaseLight(bestMoveOrig, bestMoveColor);
-                addCaseLight(bestMoveTarget, bestMoveColor);
-            }
-
-        }else if (strncmp (lineBuf, "bestmove", 8)==0){
-            if (strncmp(lineBuf+9, "(none)", 6)==0) {
-                gameStarted = false;
-                if (currentPlayer == White)
-                    playerWin[Black] = true;
-                else
-                    playerWin[White] = true;
-                print_winner();
-                return;
-            }
-            glm::ivec2 orig = glm::ivec2(lineBuf[9]-97, lineBuf[10]-49);
-            glm::ivec2 dest = glm::ivec2(lineBuf[11]-97, lineBuf[12]-49);
-
-            if (playerIsAi[currentPlayer]){
-                PceType promotion = Pawn;
-                switch (lineBuf[13]) {
-                case 'q':
-                    promotion = Queen;
-                    break;
-                case 'r':
-                    promotion = Rook;
-                    break;
-                case 'b':
-                    promotion = Bishop;
-                    break;
-                case 'n':
-                    promotion = Knight;
-                    break;
-                }
-                processMove (orig, dest, promotion);
-                switchPlayer();
-            }else if (hint){
-                switchPlayer();
-            }
-        }else if (strncmp (lineBuf, "option", 6)==0){
-
-        }
+        //pool full, the piece jumps to its square
+        mod->instanceDatas[pceIdx].modelMat = glm::translate (glm::mat4(1.0), end);
+        setInstanceIsDirty(pceIdx);
     }
+    //one engine per ai player so each keeps its own skill level and hash, a single
+    //one is enough when a human plays as it only gives hints
     void startStockFish () {
-        int pipeA[2],pipeB[2];
-
-        pipe(pipeA);
-        pipe(pipeB);
-
-        int stockFishPid;
-        stockFishPid = fork();
-
-        if (stockFishPid>0)
-        {
-            //parent
-            sfReadfd = pipeA[0];
-            sfWritefd = pipeB[1];
-            close(pipeA[1]);
-            close(pipeB[0]);
-
-            fcntl(sfReadfd, F_SETFL, O_NONBLOCK);//set read non blocking
-
-            //get onStart preemble with credits
-            char c;
-            while (true){
-                if (read (sfReadfd, &c, 1)!=1)
-                    continue;
-                if (c=='\n')
-                    break;
-                std::cout << c;
-            }
-            std::cout << std::endl;
-
-            write(sfWritefd,"uci\n",4);
-
-        } else if (stockFishPid==0) {
-            // child
-            int rfd = pipeA[1];
-            int wfd = pipeB[0];
-            close(pipeA[0]);
-            close(pipeB[1]);
-
-            dup2(wfd, STDIN_FILENO);
-            dup2(rfd, STDOUT_FILENO);  // send stdout to the pipe
-            dup2(wfd, STDERR_FILENO);  // send stderr to the pipe
-
-            close(rfd);
-            close(wfd);
-
-            std::system("stockfish");
-
-            perror ("StockFish terminated.\n");
-            _exit(0);
+        int count = game.playerIsAi[White] && game.playerIsAi[Black] ? 2 : 1;
+        if (engines.start(engineCommand, count) < count) {
+            std::cerr << "Using the builtin engine instead of '" << engineCommand << "'." << std::endl;
+            engines.start(BuiltinEngineCommand, count);
         }
+        game.engines = &engines;
+        game.playerEngine[White] = 0;
+        game.playerEngine[Black] = count - 1;
     }
 
     //actualize board[][] array
@@ -549,443 +386,246 @@ public:
             board[pce->position.x][pce->position.y] = nullptr;
         board[newPos.x][newPos.y] = pce;
         pce->position = newPos;
-        pce->hasMoved = true;
         if (animate) {
             animatePce (pce->instance, (float)newPos.x,(float)newPos.y);
             updateMiniBoard();
         }
     }
+    //i-th place of the capture zone of color c
+    static glm::ivec2 captureSlot (Color c, int i) {
+        if (c == White)
+            return glm::ivec2(-2 - i / CAPTURE_ZONE_HEIGHT, 7 - i % CAPTURE_ZONE_HEIGHT);
+        return glm::ivec2(9 + i / CAPTURE_ZONE_HEIGHT, 7 - i % CAPTURE_ZONE_HEIGHT);
+    }
+    //last piece of color c put in the capture zone
+    Piece* lastCaptured (Color c) {
+        glm::ivec2 slot = captureSlot(c, (c == White ? cptWhiteOut : cptBlackOut) - 1);
+        for (int i=0; i<32; i++)
+            if (pieces[i].captured && pieces[i].color == c && pieces[i].position == slot)
+                return &pieces[i];
+        return nullptr;
+    }
     void capturePce (Piece* p, bool animate = false) {
         board[p->position.x][p->position.y] = nullptr;
         p->captured = true;
-        p->hasMoved = true;
-
-        if (p->color == White){
-            p->position = glm::ivec2(-2 - cptWhiteOut / CAPTURE_ZONE_HEIGHT, 7 - cptWhiteOut % CAPTURE_ZONE_HEIGHT);
-            cptWhiteOut ++;
-        }else{
-            p->position = glm::ivec2(9 + cptBlackOut / CAPTURE_ZONE_HEIGHT, 7 - cptBlackOut % CAPTURE_ZONE_HEIGHT);
-            cptBlackOut ++;
-        }
+
+        if (p->color == White)
+            p->position = captureSlot(White, cptWhiteOut++);
+        else
+            p->position = captureSlot(Black, cptBlackOut++);
 
         if (!animate)
             return;
 
         if (p->promoted)
-            resetPromotion(p,true);
+            resetPromotion(p);
         animatePce (p->instance, (float)p->position.x,(float)p->position.y);
     }
 
-    void resetPromotion (Piece* p, bool rebuildCmdBuffs = true) {
+    //zero scale, the triangles of a hidden instance are degenerated and never rasterized
+    static glm::mat4 hiddenMatrix () {
+        return glm::scale(glm::mat4(1.0), glm::vec3(0.f));
+    }
+    //the recorded draws change and are to be recorded again on the next frame
+    bool drawsChanged = false;
+    //one hidden queen per color, shown in place of the pawn on the first queen promotion
+    //so the usual promotion only writes instance datas. Other promotions change the mesh
+    //of the pawn instance and record the draws again.
+    uint32_t    spareQueens[2];
+    Piece*      spareQueenOwner[2] = {nullptr, nullptr};
+    //show instance in place of the current one of p, only instance datas are written
+    void showInstance (Piece* p, uint32_t instance) {
+        if (instance == p->instance)
+            return;
+        mod->instanceDatas[instance].modelMat = mod->instanceDatas[p->instance].modelMat;
+        mod->instanceDatas[p->instance].modelMat = hiddenMatrix();
+        setInstanceIsDirty(instance);
+        setInstanceIsDirty(p->instance);
+        animations.retarget(p->instance, instance);
+        p->instance = instance;
+    }
+    void resetPromotion (Piece* p) {
+        if (spareQueenOwner[p->color] == p) {
+            showInstance(p, p->pawnInstance);
+            spareQueenOwner[p->color] = nullptr;
+        } else {
+            mod->instances[p->pawnInstance] = mod->getPrimitiveIndex("pawn");
+            drawsChanged = true;
+        }
         p->type = Pawn;
         p->promoted = false;
-        mod->instances[p->instance] = mod->getPrimitiveIndex("pawn");
-        if (rebuildCmdBuffs)
-            rebuildCommandBuffers();
     }
-    void promote(Piece* p, PceType promotion) {
-        uint32_t primIdx;
-        switch (promotion) {
-        case Queen:
-            primIdx = mod->getPrimitiveIndex("queen");
-            break;
-        case Bishop:
-            primIdx = mod->getPrimitiveIndex("bishop");
-            break;
-        case Rook:
-            primIdx = mod->getPrimitiveIndex("rook");
-            break;
-        case Knight:
-            primIdx = mod->getPrimitiveIndex("knight");
-            break;
+    void promote (Piece* p, PceType promotion) {
+        if (promotion == Queen && !spareQueenOwner[p->color]) {
+            spareQueenOwner[p->color] = p;
+            showInstance(p, spareQueens[p->color]);
+        } else {
+            const char* models[] = {"pawn", "rook", "knight", "bishop", "queen", "king"};
+            mod->instances[p->pawnInstance] = mod->getPrimitiveIndex(models[promotion]);
+            drawsChanged = true;
         }
-        mod->instances[p->instance] = primIdx;
-        rebuildCommandBuffers();
         p->promoted = true;
         p->type = promotion;
     }
 
-    void replay (int untilPtr) {
-        resetBoard(false);
-
-        while (movesPtr<untilPtr) {
-            glm::ivec2 orig = glm::ivec2(movesBuffer[movesPtr]-97, movesBuffer[movesPtr+1]-49);
-            glm::ivec2 dest = glm::ivec2(movesBuffer[movesPtr+2]-97, movesBuffer[movesPtr+3]-49);
-            std::cout << "replay (" << std::to_string(orig.x + 1) << ", " << std::to_string(orig.y + 1) << ") => ("
-                      << std::to_string(dest.x + 1) << ", " << std::to_string(dest.y + 1) << ")" << std::endl;
-            PceType promotion = Pawn;
-            if (movesBuffer[movesPtr+4] != 0x20) {
-                switch (movesBuffer[movesPtr+4]) {
-                case 'q':
-                    promotion = Queen;
-                    break;
-                case 'r':
-                    promotion = Rook;
-                    break;
-                case 'b':
-                    promotion = Bishop;
-                    break;
-                case 'n':
-                    promotion = Knight;
-                    break;
-                }
-            }
-            processMove (orig, dest, promotion, false);
-            switchPlayer(false);
-        }
+    static glm::ivec2 caseOf (int sq) {
+        return glm::ivec2(chess::fileOf(sq), chess::rankOf(sq));
     }
-    void undo () {
 
-        if (movesPtr < 25)
-            return;
-        std::cout << "Previous  : " + std::string(movesBuffer,movesPtr) << std::endl;
-        replay (previouMovesPtr);
-        if (playerIsAi[currentPlayer] && movesPtr>24)
-            replay (previouMovesPtr);
-        std::cout << "After undo: " + std::string(movesBuffer,movesPtr) << std::endl;
-        rebuildCommandBuffers();
-        for (int i=0; i<32; i++){
-            glm::vec3 curPos = pieces[i].getCurrentPosition(mod);
-            //glm::vec3(x*2 - 7,0, 7 - y*2)),
-            if ((int)curPos.x != (pieces[i].position.x*2-7) || (int)curPos.z != (7-2*pieces[i].position.y))
-                animatePce (pieces[i].instance, (float)pieces[i].position.x,(float)pieces[i].position.y);
-        }
-        updateMiniBoard();
-        startTurn();
+    //follow the game on the 3d board
+    void movePlayed (const ChessGame&, chess::Move m) {
+        glm::ivec2 orig = caseOf(chess::moveFrom(m));
+        glm::ivec2 dest = caseOf(chess::moveTo(m));
+        Piece* p = getPiece(orig);
+
+        if (p->type == King)
+            setCaseRedLight(p->position, 0);
+
+        Piece* captured = nullptr;
+        if (chess::isCastling(m)){//rocking
+            //move tower
+            Piece* r = (dest.x == 6) ? board[7][dest.y] : board[0][dest.y];
+            boardMove(r, glm::ivec2(dest.x == 6 ? 5 : 3, dest.y), true);
+        }else if (chess::moveFlags(m) == chess::EnPassant)
+            captured = board[dest.x][orig.y];
+        else if (chess::isCapture(m))
+            captured = getPiece(dest);
+
+        if (captured)
+            capturePce (captured, true);
+        //normal move
+        boardMove(p, dest, true);
+
+        if (chess::isPromotion(m))
+            promote(p, (PceType)chess::promotionType(m));
     }
-
-    void processMove (glm::ivec2 orig, glm::ivec2 dest, PceType promotion = Pawn, bool animate = true) {
-        if (orig == dest)
-            return;
-        Piece* p    = getPiece(orig);
-        Piece* pDest= getPiece(dest);
-
-
-        if (p) {
-            if (p->type == King && animate)
-                setCaseRedLight(p->position, 0);
-
-            if (p->type == King && abs(orig.x - dest.x)>1){//rocking
-                //move tower
-                if (dest.x == 6)//right tower
-                    boardMove(board[7][dest.y], glm::ivec2(5,dest.y), animate);
-                else
-                    boardMove(board[0][dest.y], glm::ivec2(3,dest.y), animate);
-            }else if (pDest) {//capture
-                if (pDest->color != p->color)
-                    capturePce (pDest, animate);
-                else {
-                    std::cerr << "Unexpected Piece on case: (" << dest.x << "," << dest.y << ")" << std::endl;
-                    exit(-1);
-                }
-            }else if (p->type == Pawn) {
-                if (orig.x != dest.x) //pawn attack
-                    capturePce (board[dest.x][orig.y], animate);
-            }
-            //normal move
-            boardMove(board[orig.x][orig.y], dest, animate);
-        }
-
-        previouMovesPtr = movesPtr;
-        movesBuffer[movesPtr++]=orig.x + 97;//ascii pos
-        movesBuffer[movesPtr++]=orig.y + 49;
-        movesBuffer[movesPtr++]=dest.x + 97;
-        movesBuffer[movesPtr++]=dest.y + 49;
-
-        if (promotion != Pawn) {
-            switch (promotion) {
-            case Queen:
-                movesBuffer[movesPtr++]='q';
-                break;
-            case Bishop:
-                movesBuffer[movesPtr++]='b';
-                break;
-            case Rook:
-                movesBuffer[movesPtr++]='r';
-                break;
-            case Knight:
-                movesBuffer[movesPtr++]='n';
-                break;
-            }
-            promote(p, promotion);
+    void moveTakenBack (const ChessGame& g, chess::Move m) {
+        glm::ivec2 orig = caseOf(chess::moveFrom(m));
+        glm::ivec2 dest = caseOf(chess::moveTo(m));
+
+        Piece* p = getPiece(dest);
+        if (chess::isPromotion(m))
+            resetPromotion(p);
+        boardMove(p, orig, true);
+
+        if (chess::isCastling(m))
+            boardMove(board[dest.x == 6 ? 5 : 3][dest.y], glm::ivec2(dest.x == 6 ? 7 : 0, dest.y), true);
+        if (chess::isCapture(m)) {
+            Piece* c = lastCaptured((Color)~g.position.side);
+            if (c->color == White)
+                cptWhiteOut--;
+            else
+                cptBlackOut--;
+            glm::ivec2 sq = chess::moveFlags(m) == chess::EnPassant ? glm::ivec2(dest.x, orig.y) : dest;
+            boardMove(c, sq, true);
+            c->captured = false;
+            //a promoted piece was reset to a pawn when captured
+            PceType type = (PceType)g.position.pieceOn(chess::square(sq.x, sq.y));
+            if (type != c->type)
+                promote(c, type);
         }
-
-        movesBuffer[movesPtr++]=0x20;//space
+        setCaseRedLight(getKing(White)->position, 0);
+        setCaseRedLight(getKing(Black)->position, 0);
     }
 
-    bool validateMoves (Piece* p) {
-        std::vector<glm::ivec2> moves = validMoves;
-
-        std::vector<glm::ivec2>::iterator itr = moves.begin();
-        for ( ; itr != moves.end(); ) {
-            if (!PreviewBoard(p, *itr))
-                itr = moves.erase(itr);
-             else
-                ++itr;
-        }
-        validMoves = moves;
-    }
     Piece* getKing (Color player) {
         return (player==White)? &pieces[4] : &pieces[20];
     }
-    bool kingIsSafe(Color player){
-        Piece* k = getKing(player);
-
-        int pStartOffset = (k->color == White)?16:0;//we check moves of opponent
-        for (int pIdx=pStartOffset; pIdx<pStartOffset+16; pIdx++) {
-            validMoves.clear();
-            computeValidMove(&pieces[pIdx]);
-            if (std::find(validMoves.begin(), validMoves.end(), k->position)!=validMoves.end()){
-                validMoves.clear();
-                return false;
-            }
-        }
-        validMoves.clear();
-        return true;
-    }
-
-    bool PreviewBoard(Piece* p, glm::ivec2 newPos){
-        std::vector<glm::ivec2> saveCurrentValidMoves = validMoves;
-        Piece savedPces[32] = {};
-        memcpy (savedPces, pieces, 32*sizeof(Piece));
-        Piece* savedBoard[8][8] = {};
-        memcpy (savedBoard, board, 64*sizeof(Piece*));
-        int savedCptWhiteOut = cptWhiteOut;
-        int savedCptBlackOut = cptBlackOut;
-
-        processMove (p->position, newPos, Pawn, false);
-
-        bool kingOk = kingIsSafe(p->color);
-
-        previouMovesPtr-=5;
-        movesPtr-=5;
-        memcpy (pieces, savedPces, 32*sizeof(Piece));
-        memcpy (board, savedBoard, 64*sizeof(Piece*));
-        validMoves = saveCurrentValidMoves;
-        cptWhiteOut = savedCptWhiteOut;
-        cptBlackOut = savedCptBlackOut;
-
-        return kingOk;
-    }
-
-    std::vector<glm::ivec2> validMoves;
 
-    void checkSingleMove (Piece* p, int deltaX, int deltaY) {
-        glm::ivec2 delta = glm::ivec2(deltaX, deltaY);
-        glm::ivec2 newPos = p->position + delta;
-
-        if (newPos.x < 0 || newPos.x > 7 || newPos.y < 0 || newPos.y > 7)
-            return;
-
-        Piece* target = board[newPos.x][newPos.y];
-
-        if (!target) {//target cell is empty
-            if (p->type == Pawn){//current cell is pawn
-                if (delta.x != 0){//check En passant capturing
-                    if (previouMovesPtr<24)
-                        return;
-                    target = board[newPos.x][p->position.y];
-                    if (!target)
-                        return;
-                    if (target->color == p->color || p->type != Pawn)
-                        return;
-                    if (p->color == Black) {
-                        if (newPos.y != 2)
-                            return;
-                        if ((movesBuffer[previouMovesPtr]-97 != newPos.x) ||
-                                (movesBuffer[previouMovesPtr+2]-97 != newPos.x) ||//not a straight move asside
-                                (movesBuffer[previouMovesPtr+1]-49 != 1) ||
-                                (movesBuffer[previouMovesPtr+3]-49 != 3))
-                            return;
-                    }else{
-                        if (newPos.y != 5)
-                            return;
-                        if ((movesBuffer[previouMovesPtr]-97 != newPos.x) ||
-                                (movesBuffer[previouMovesPtr+2]-97 != newPos.x) ||//not a straight move asside
-                                (movesBuffer[previouMovesPtr+1]-49 != 6) ||
-                                (movesBuffer[previouMovesPtr+3]-49 != 4))
-                            return;
-                    }
-                }
-            }
-            validMoves.push_back(newPos);
-            return;
-        }else if (p->color == target->color)//target cell is not empty
-            return;
-        else if (p->type == Pawn && deltaX == 0)//pawn cant take forward
-            return;
+    chess::MoveList validMoves;//legal moves of the selected piece
 
-        validMoves.push_back(newPos);
+    static glm::ivec2 moveTarget (chess::Move m) {
+        return glm::ivec2(chess::fileOf(chess::moveTo(m)), chess::rankOf(chess::moveTo(m)));
     }
-    void checkIncrementalMove (Piece* p, int deltaX, int deltaY){
-        glm::ivec2 delta = glm::ivec2(deltaX, deltaY);
-        glm::ivec2 newPos = p->position + delta;
-
-        while (newPos.x >= 0 && newPos.x < 8 && newPos.y >= 0 && newPos.y < 8){
-            Piece* target = board[newPos.x][newPos.y];
-            if (target) {
-                if (target->color != p->color)
-                    validMoves.push_back(newPos);
-                break;
-            }
-            validMoves.push_back(newPos);
-            newPos += delta;
+    void computeValidMoves (Piece* p) {
+        chess::MoveList moves;
+        game.position.generateLegal (moves);
+        int from = chess::square(p->position.x, p->position.y);
+        for (chess::Move m : moves) {
+            if (chess::moveFrom(m) != from)
+                continue;
+            if (chess::isPromotion(m) && chess::promotionType(m) != chess::Queen)
+                continue;//promotion is always to queen from the ui
+            validMoves.push(m);
         }
     }
 
-    void checkCastling (Piece* k) {
-        if (k->hasMoved)
-            return;
-        bool castlingOk = true;
-        int pceOffset = (k->color == Black) ? 16 : 0;
-        //TODO: check king is safe on rook position
-
-        //check if tower is in place
-        if (!pieces[pceOffset].hasMoved) {
-            //castling long
-            for (int i=k->position.x-1; i>0; i--){
-                if (board[i][k->position.y]){
-                    castlingOk=false;
-                    break;
-                }
-                if (!PreviewBoard(k, glm::ivec2(i, k->position.y))){
-                    castlingOk=false;
-                    break;
-                }
-            }
-            if (castlingOk && !pieces[pceOffset].hasMoved)
-                validMoves.push_back(glm::ivec2(k->position.x-2,k->position.y));
+    //put the 3d pieces on the squares of the game position, a pawn stands for a piece
+    //missing from the set and spare pieces go to the capture zone
+    void resetBoard(bool animate = true) {
+        const chess::Position& pos = game.position;
+        int squareOf[32];//-1 if not on the board
+        bool placed[64] = {};
+        cptWhiteOut = cptBlackOut = 0;
+
+        for (int i=0; i<32; i++) {
+            squareOf[i] = -1;
+            if (pieces[i].promoted)
+                resetPromotion (&pieces[i]);
         }
-        //castling short
-        if (!pieces[pceOffset + 7].hasMoved) {
-            castlingOk = true;
-            for (int i=k->position.x+1; i<7;i++){
-                if (board[i][k->position.y]){
-                    castlingOk=false;
-                    break;
-                }
-                if (!PreviewBoard(k, glm::ivec2(i, k->position.y))){
-                    castlingOk=false;
-                    break;
-                }
+        //pieces matching their initial square first, so the start position is the initial layout
+        for (int i=0; i<32; i++) {
+            int sq = chess::square(pieces[i].initPosition.x, pieces[i].initPosition.y);
+            if (pos.pieceOn(sq) == (chess::PceType)pieces[i].type && pos.colorOn(sq) == (chess::Color)pieces[i].color) {
+                squareOf[i] = sq;
+                placed[sq] = true;
             }
-            if (castlingOk && !pieces[7+pceOffset].hasMoved)
-                validMoves.push_back(glm::ivec2(k->position.x+2,k->position.y));
         }
-    }
-    void computeValidMove(Piece* p){
-        if (p->captured)
-            return;
-
-        int validMoveStart = validMoves.size();
-
-        if (p->type == Pawn) {
-            int pawnDirection = (p->color == White)? 1 : -1;
-            checkSingleMove (p, 0, 1 * pawnDirection);
-            if (!p->hasMoved)
-                checkSingleMove (p, 0, 2 * pawnDirection);
-            checkSingleMove (p,-1, 1 * pawnDirection);
-            checkSingleMove (p, 1, 1 * pawnDirection);
-        }else if (p->type == Rook) {
-            checkIncrementalMove (p, 0, 1);
-            checkIncrementalMove (p, 0,-1);
-            checkIncrementalMove (p, 1, 0);
-            checkIncrementalMove (p,-1, 0);
-        }else if (p->type == Knight) {
-            checkSingleMove (p, 2, 1);
-            checkSingleMove (p, 2,-1);
-            checkSingleMove (p,-2, 1);
-            checkSingleMove (p,-2,-1);
-            checkSingleMove (p, 1, 2);
-            checkSingleMove (p,-1, 2);
-            checkSingleMove (p, 1,-2);
-            checkSingleMove (p,-1,-2);
-        }else if (p->type == Bishop) {
-            checkIncrementalMove (p, 1, 1);
-            checkIncrementalMove (p,-1,-1);
-            checkIncrementalMove (p, 1,-1);
-            checkIncrementalMove (p,-1, 1);
-        }else if (p->type == Queen) {
-            checkIncrementalMove (p, 0, 1);
-            checkIncrementalMove (p, 0,-1);
-            checkIncrementalMove (p, 1, 0);
-            checkIncrementalMove (p,-1, 0);
-            checkIncrementalMove (p, 1, 1);
-            checkIncrementalMove (p,-1,-1);
-            checkIncrementalMove (p, 1,-1);
-            checkIncrementalMove (p,-1, 1);
-        }else if (p->type == King){
-            checkCastling   (p);
-
-            checkSingleMove (p,-1,-1);
-            checkSingleMove (p,-1, 0);
-            checkSingleMove (p,-1, 1);
-            checkSingleMove (p, 0,-1);
-            checkSingleMove (p, 0, 1);
-            checkSingleMove (p, 1,-1);
-            checkSingleMove (p, 1, 0);
-            checkSingleMove (p, 1, 1);
+        for (int sq=0; sq<64; sq++) {
+            if (placed[sq] || pos.pieceOn(sq) == chess::NoPce)
+                continue;
+            Color c = (Color)pos.colorOn(sq);
+            PceType t = (PceType)pos.pieceOn(sq);
+            int found = -1;
+            for (int i=0; i<32 && found < 0; i++)
+                if (squareOf[i] < 0 && pieces[i].color == c && pieces[i].type == t)
+                    found = i;
+            for (int i=0; i<32 && found < 0; i++)
+                if (squareOf[i] < 0 && pieces[i].color == c && pieces[i].type == Pawn)
+                    found = i;
+            if (found < 0) {
+                std::cerr << "No piece left to show on " << caseX[chess::fileOf(sq)] << chess::rankOf(sq) + 1 << std::endl;
+                continue;
+            }
+            squareOf[found] = sq;
+            if (pieces[found].type != t)
+                promote (&pieces[found], t);
         }
-    }
-    void resetBoard(bool animate = true) {
-        currentPlayer = White;
-        cptWhiteOut = cptBlackOut = 0;
 
+        for (int x=0; x<8; x++)
+            for (int y=0; y<8; y++)
+                board[x][y] = nullptr;
         for (int i=0; i<32; i++) {
             Piece* p = &pieces[i];
-            if (p->promoted)
-                resetPromotion (p, false);
-            if (p->position != p->initPosition){
-                board[p->initPosition.x][p->initPosition.y] = p;
-                p->position = p->initPosition;
+            glm::ivec2 target;
+            p->captured = squareOf[i] < 0;
+            if (p->captured)
+                target = captureSlot(p->color, p->color == White ? cptWhiteOut++ : cptBlackOut++);
+            else {
+                target = caseOf(squareOf[i]);
+                board[target.x][target.y] = p;
+            }
+            if (p->position != target) {
+                p->position = target;
                 if (animate)
                     animatePce (p->instance, (float)p->position.x,(float)p->position.y);
             }
-            p->captured = false;
-            p->hasMoved = false;
         }
-        for (int x=0; x<8; x++){
-            if (animate){
-                setCaseLight(glm::ivec2(x,0), glm::vec4(0));
-                setCaseLight(glm::ivec2(x,1), glm::vec4(0));
-            }
-            for (int y=2; y<6; y++){
-                board[x][y] = nullptr;
-                if (animate)
+        if (animate) {
+            for (int x=0; x<8; x++)
+                for (int y=0; y<8; y++)
                     setCaseLight(glm::ivec2(x,y), glm::vec4(0));
-            }
-            if (animate){
-                setCaseLight(glm::ivec2(x,6), glm::vec4(0));
-                setCaseLight(glm::ivec2(x,7), glm::vec4(0));
-            }
-        }
-        if (animate)
             updateMiniBoard();
-        movesPtr = previouMovesPtr = 24;
+        }
     }
 
     void startGame () {
-        gameStarted = false;
-        playerWin[White] = playerWin[Black] = false;
-
+        game.newGame();
+    }
+    void gameReset (const ChessGame&) {
+        clearBestMove();
         resetBoard();
         updateMiniBoard();
-
-        rebuildCommandBuffers();
-
-        strncpy(movesBuffer, "position startpos moves ", 24);
-
-        write(sfWritefd,"isready\n",8);
-        //enableHint();
-    }
-    void switchPlayer (bool _startTurn = true) {
-        if (currentPlayer==White)
-            currentPlayer = Black;
-        else
-            currentPlayer = White;
-
-        if (_startTurn)
-            startTurn();
     }
     void clearBestMove () {
         if (bestMoveOrig.x >=0){
@@ -994,7 +634,19 @@ public:
         }
         bestMoveOrig = bestMoveTarget = glm::vec2(-1);
     }
-    void startTurn (){
+    void hintChanged (const ChessGame&, chess::Move m) {
+        clearBestMove();
+        if (m == chess::NoMove)
+            return;
+        bestMoveOrig = caseOf(chess::moveFrom(m));
+        bestMoveTarget = caseOf(chess::moveTo(m));
+        addCaseLight(bestMoveOrig, bestMoveColor);
+        addCaseLight(bestMoveTarget, bestMoveColor);
+    }
+    void gameEnded (const ChessGame&) {
+        print_winner();
+    }
+    void turnStarted (const ChessGame& g) {
         if (selectedSquare.x >= 0)
             subCaseLight(selectedSquare, selectedColor);
         if (hoverSquare.x >= 0)
@@ -1002,24 +654,14 @@ public:
 
         hoverSquare = selectedSquare = glm::vec2(-1);
 
-        clearBestMove();
-
         for (int i=0; i<validMoves.size(); i++)
-            subCaseLight(validMoves[i], validMoveColor);
+            subCaseLight(moveTarget(validMoves[i]), validMoveColor);
         validMoves.clear();
 
-        if (kingIsSafe(currentPlayer))
-            setCaseLight(getKing(currentPlayer)->position, glm::vec4(0));
-        else
-            setCaseLight(getKing(currentPlayer)->position, checkColor);
-
-        sendPositionsCmd();
-        if (playerIsAi[currentPlayer]){
-            write(sfWritefd, sfcmdGo.c_str() , sfcmdGo.length());
-        }else if (hint)
-            write(sfWritefd,"go infinite\n", 12);
+        if (!g.position.inCheck())
+            setCaseLight(getKing((Color)g.position.side)->position, glm::vec4(0));
         else
-            write(sfWritefd,"go\n", 3);
+            setCaseLight(getKing((Color)g.position.side)->position, checkColor);
     }
 
     void addPiece (uint32_t pIdx, const std::string& model, PceType type, Color color, int x, int y, float yAngle = 0.f) {
@@ -1035,6 +677,7 @@ public:
                     glm::rotate(
                         glm::translate(glm::mat4(1.0), glm::vec3(x*2 - 7,0, 7 - y*2)),
                     yAngle, glm::vec3(0,1,0)), matIdx);
+        pieces[pIdx].pawnInstance = pieces[pIdx].instance;
         board[x][y] = &pieces[pIdx];
     }
 
@@ -1050,11 +693,11 @@ public:
     }
     void setCaseLight (glm::ivec2 c, glm::vec4 color) {
         mod->instanceDatas[casesInstances[c.x][c.y]].color = color;
-        mod->setInstanceIsDirty(casesInstances[c.x][c.y]);
+        setInstanceIsDirty(casesInstances[c.x][c.y]);
     }
     void setCaseRedLight (glm::ivec2 p, float c) {
         mod->instanceDatas[casesInstances[p.x][p.y]].color.x = c;
-        mod->setInstanceIsDirty(casesInstances[p.x][p.y]);
+        setInstanceIsDirty(casesInstances[p.x][p.y]);
     }
     inline void addCaseLight (glm::ivec2 c, glm::vec4 color) {
         addCaseLight(c.x, c.y, color);
@@ -1065,11 +708,11 @@ public:
 
     void addCaseLight (uint32_t x, uint32_t y, glm::vec4 color) {
         mod->instanceDatas[casesInstances[x][y]].color += color;
-        mod->setInstanceIsDirty(casesInstances[x][y]);
+        setInstanceIsDirty(casesInstances[x][y]);
     }
     void subCaseLight (uint32_t x, uint32_t y, glm::vec4 color) {
         mod->instanceDatas[casesInstances[x][y]].color -= color;
-        mod->setInstanceIsDirty(casesInstances[x][y]);
+        setInstanceIsDirty(casesInstances[x][y]);
     }
 
     glm::vec3 vMouse, vMouseN;
@@ -1123,28 +766,17 @@ public:
             return;
 
         if (selectedSquare.x >= 0) {
-            Piece* p = board[selectedSquare.x][selectedSquare.y];
-            std::vector<glm::ivec2>::iterator pos = std::find(validMoves.begin(), validMoves.end(), hoverSquare);
+            const chess::Move* pos = std::find_if(validMoves.begin(), validMoves.end(),
+                                    [this](chess::Move m) { return moveTarget(m) == hoverSquare; });
             if (pos!=validMoves.end()){
-                //check pawn promotion
-                int promoteRow = (p->color == White) ? 7 : 0;
-                if (pos->y ==  promoteRow && p->type == Pawn && !p->promoted){
-                    //promote dialog
-
-                    processMove(p->position, *pos, Queen);
-                }else
-                    processMove(p->position, *pos);
-
-                if (hint)
-                    write(sfWritefd,"stop\n",5);
-                else
-                    switchPlayer();
+                //promotion is always to queen, validMoves only holds those
+                game.playMove(*pos);
                 return;
             }
         }
 
         for (int i=0; i<validMoves.size(); i++)
-            subCaseLight(validMoves[i], validMoveColor);
+            subCaseLight(moveTarget(validMoves[i]), validMoveColor);
         validMoves.clear();
 
         if (selectedSquare.x >= 0)
@@ -1157,12 +789,11 @@ public:
             Piece* p = board[selectedSquare.x][selectedSquare.y];
             if (!p)
                 return;
-            if (p->color != currentPlayer || playerIsAi[currentPlayer])
+            if (p->color != (Color)game.position.side || game.playerIsAi[game.position.side] || game.isOver())
                 return;
-            computeValidMove (p);
-            validateMoves(p);
+            computeValidMoves (p);
             for (int i=0; i<validMoves.size(); i++)
-                addCaseLight(validMoves[i], validMoveColor);
+                addCaseLight(moveTarget(validMoves[i]), validMoveColor);
         }
     }
     virtual void handleMouseMove(int32_t x, int32_t y) {
@@ -1207,13 +838,20 @@ public:
             startGame();
             break;
         case GLFW_KEY_R://r: redo last undo
-            startGame();
+            game.redo();
             break;
         case GLFW_KEY_U://u: undo last human move
-            undo();
+            game.undo();
             break;
         case GLFW_KEY_H://h
-            toogleHint();
+            game.toggleHint();
+            break;
+        case GLFW_KEY_F://f: print current position
+            std::cout << game.position.fen() << std::endl;
+            break;
+        case GLFW_KEY_S://s: print instance upload counters
+            std::cout << "instance uploads: " << uploadStats.uploadFrames << " of " << uploadStats.frames
+                      << " frames, " << uploadStats.flags << " instance changes" << std::endl;
             break;
         default:
             VkEngine::keyPressed(key);
@@ -1268,6 +906,8 @@ public:
             addPiece(8 + i, "pawn", Pawn, White, i, 1);
         for (int i=0; i<8; i++)
             addPiece(24 + i, "pawn", Pawn, Black, i, 6);
+        spareQueens[White] = mod->addInstance("queen", hiddenMatrix());
+        spareQueens[Black] = mod->addInstance("queen", hiddenMatrix(), blackMatIdx);
 
         for (int y=0; y<8; y++)
             for (int x=0; x<8; x++)
@@ -1308,6 +948,9 @@ public:
 
         prepareRenderers();
 
+        game.observer = this;
+        game.replyCache = &replyCache;
+        game.book = &book;
         startStockFish();
 
         startGame();
@@ -1344,8 +987,73 @@ int main(const int argc, const char *argv[])
 {
 
     for (size_t i = 0; i < argc; i++) { VkChess::args.push_back(argv[i]); };
+
+    std::string engineCommand = "stockfish";
+    std::string goCommand = "go depth 12";
+    std::string startFen;
+    std::string replyCachePath;
+    std::string bookPath;
+    for (int i = 1; i < argc - 1; i++) {
+        if (strcmp(argv[i], "--engine") == 0)
+            engineCommand = argv[i+1];
+        else if (strcmp(argv[i], "--go") == 0)
+            goCommand = argv[i+1];
+        else if (strcmp(argv[i], "--fen") == 0)
+            startFen = argv[i+1];
+        else if (strcmp(argv[i], "--reply-cache") == 0)
+            replyCachePath = argv[i+1];
+        else if (strcmp(argv[i], "--book") == 0)
+            bookPath = argv[i+1];
+    }
+
+    //modes without vulkan
+    for (int i = 1; i < argc; i++) {
+        //move generator check against reference perft counts
+        if (strcmp(argv[i], "--perft") == 0)
+            return chess::runPerftSuite (i+1 < argc ? atoi(argv[i+1]) : 4) +
+                   chess::runKeySuite (1000, 400) + chess::runFenSuite () ? EXIT_FAILURE : EXIT_SUCCESS;
+        //multi threaded perft, divided by root move when a position is given with --fen
+        if (strcmp(argv[i], "--perft-mt") == 0) {
+            int depth = i+1 < argc ? atoi(argv[i+1]) : 5;
+            //hardware_concurrency is 0 when unknown
+            int threads = std::max(1, i+2 < argc ? atoi(argv[i+2]) : (int)std::thread::hardware_concurrency());
+            if (depth < 1) {
+                std::cerr << "Invalid perft depth: " << argv[i+1] << std::endl;
+                return EXIT_FAILURE;
+            }
+            if (startFen.empty())
+                return chess::runParallelPerftSuite (depth, threads) ? EXIT_FAILURE : EXIT_SUCCESS;
+            chess::Position pos;
+            if (!pos.setFen(startFen)) {
+                std::cerr << "Invalid FEN: " << startFen << std::endl;
+                return EXIT_FAILURE;
+            }
+            std::vector<chess::PerftDivide> divide;
+            uint64_t nodes = chess::parallelPerft (pos, depth, threads, 256, &divide);
+            for (const chess::PerftDivide& d : divide)
+                std::cout << chess::moveToUci(d.move) << ": " << d.nodes << std::endl;
+            std::cout << "nodes: " << nodes << std::endl;
+            return EXIT_SUCCESS;
+        }
+        if (strcmp(argv[i], "--fake-uci") == 0)
+            return chess::runFakeUciEngine ();
+        if (strcmp(argv[i], "--headless") == 0)
+            return runHeadless (engineCommand, i+1 < argc ? atoi(argv[i+1]) : 1,
+                                i+2 < argc ? atoi(argv[i+2]) : 1, startFen) ? EXIT_FAILURE : EXIT_SUCCESS;
+        if (strcmp(argv[i], "--analyse") == 0 && i+1 < argc)
+            return runAnalysis (engineCommand, argv[i+1], i+2 < argc ? atoi(argv[i+2]) : 1,
+                                goCommand) ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
     vkChess = new VkChess();
+    vkChess->engineCommand = engineCommand;
+    vkChess->game.startFen = startFen;
+    if (!replyCachePath.empty())
+        vkChess->replyCache.load(replyCachePath);
+    if (!bookPath.empty())
+        vkChess->book.open(bookPath.c_str());
     vkChess->start();
+    if (!replyCachePath.empty() && !vkChess->replyCache.save(replyCachePath))
+        std::cerr << "Unable to save the reply cache to " << replyCachePath << std::endl;
     delete(vkChess);
     return 0;
 }
@@ -0,0 +1,300 @@
+#include <string.h>
+#include <iostream>
+#include <algorithm>
+
+#include "chessgame.h"
+
+bool ChessGame::newGame () {
+    stopSearches();
+
+    bool valid = true;
+    if (startFen.empty())
+        position.setStartPosition();
+    else if (!(valid = position.setFen(startFen))) {
+        std::cerr << "Invalid FEN: " << startFen << std::endl;
+        position.setStartPosition();
+    }
+    keyHistory.clear();
+    termination = chess::NotTerminated;
+    failed      = false;
+    moves.clear();
+    undos.clear();
+    historyPtr  = 0;
+    started     = false;
+    lastHint    = chess::NoMove;
+
+    if (observer)
+        observer->gameReset(*this);
+
+    if (!engines)
+        return valid;
+    for (size_t i = 0; i < engines->size(); i++) {
+        (*engines)[i].session.reset();
+        (*engines)[i].session.send("ucinewgame");
+        (*engines)[i].session.send("isready");
+    }
+    return valid;
+}
+
+void ChessGame::poll (int maxMessages) {
+    if (pendingReply != chess::NoMove) {
+        chess::Move m = pendingReply;
+        pendingReply = chess::NoMove;
+        applyMove(m);
+        startTurn();
+    }
+    if (!engines)
+        return;
+    UciMessage msg;
+    for (size_t e = 0; e < engines->size(); e++)
+        for (int i = 0; i < maxMessages && (*engines)[e].reader.messages.pop(msg); i++)
+            handleMessage(e, msg);
+}
+
+void ChessGame::playMove (chess::Move m) {
+    //a hint search is for the position we are leaving, a ponder search goes on
+    //if it guessed the move
+    bool hit = m == ponderMove && m != chess::NoMove;
+    if (!hit)
+        stopSearches();
+    ponderMove  = chess::NoMove;
+    ponderHit   = hit;
+    setHint(chess::NoMove);
+    applyMove(m);
+    startTurn();
+}
+
+void ChessGame::undo () {
+    if (historyPtr == 0)
+        return;
+    stopSearches();
+    setHint(chess::NoMove);
+    takeBack();
+    if (playerIsAi[position.side] && historyPtr > 0)
+        takeBack();
+    startTurn();
+}
+void ChessGame::redo () {
+    if (historyPtr == moves.size())
+        return;
+    stopSearches();
+    setHint(chess::NoMove);
+    applyMove(moves[historyPtr]);
+    if (playerIsAi[position.side] && historyPtr < moves.size())
+        applyMove(moves[historyPtr]);
+    startTurn();
+}
+
+void ChessGame::toggleHint () {
+    hint = !hint;
+    setHint(chess::NoMove);
+
+    if (playerIsAi[position.side] || isOver())
+        return;
+    //hints and pondering share the engine
+    stopSearches();
+    if (hint)
+        startHint();
+}
+
+//apply a legal move and push it on the history, redo entries are kept if the
+//move is the next one of the history
+void ChessGame::applyMove (chess::Move m) {
+    if (historyPtr < moves.size() && moves[historyPtr] != m) {
+        moves.resize(historyPtr);
+        undos.resize(historyPtr);
+    }
+    if (historyPtr == moves.size()) {
+        moves.push_back(m);
+        undos.push_back(chess::UndoInfo());
+    }
+    keyHistory.push_back(position.key);
+    position.doMove(m, undos[historyPtr]);
+    historyPtr++;
+    termination = chess::checkTermination(position, keyHistory.data(), keyHistory.size());
+
+    if (observer)
+        observer->movePlayed(*this, m);
+}
+void ChessGame::takeBack () {
+    chess::Move m = moves[--historyPtr];
+    position.undoMove(m, undos[historyPtr]);
+    keyHistory.pop_back();
+    termination = chess::NotTerminated;
+    failed      = false;
+
+    if (observer)
+        observer->moveTakenBack(*this, m);
+}
+
+void ChessGame::startTurn () {
+    started = true;
+    if (observer)
+        observer->turnStarted(*this);
+
+    if (isOver()) {
+        stopSearches();
+        started = false;
+        if (observer)
+            observer->gameEnded(*this);
+        return;
+    }
+
+    if (playerIsAi[position.side]) {
+        if (ponderHit) {
+            ponderHit = false;
+            uci(position.side).send("ponderhit");
+            return;
+        }
+        if (book && (pendingReply = book->probe(position)) != chess::NoMove)
+            return;
+        if (findReply(goCommand, pendingReply))
+            return;
+        sendPosition(position.side);
+        go(position.side, goCommand);
+    } else if (hint)
+        startHint();
+    else if (ponderMove != chess::NoMove)
+        startPonder();
+}
+
+//the cached hint shows at once, the search goes on to refine it
+void ChessGame::startHint () {
+    chess::Move m;
+    if (findReply("go infinite", m))
+        setHint(m);
+    sendPosition(position.side);
+    go(position.side, "go infinite");
+}
+
+//the ai engine searches the position after the expected human move with the ai
+//limits, they only start counting on ponderhit
+void ChessGame::startPonder () {
+    chess::Color ai = ~position.side;
+    sendPosition(ai, ponderMove);
+    go(ai, goCommand.compare(0, 3, "go ") ? "go ponder" : "go ponder " + goCommand.substr(3));
+}
+
+uint64_t ChessGame::replyKey (const std::string& goCmd) const {
+    return ReplyCache::key(position.key, level[position.side], goCmd);
+}
+
+//cached reply of the side to move for goCmd, checked against a key collision.
+//m is only written with a legal move, as startTurn plays it on the next poll.
+bool ChessGame::findReply (const std::string& goCmd, chess::Move& m) {
+    chess::Move cached;
+    if (!replyCache || !replyCache->find(replyKey(goCmd), cached))
+        return false;
+    chess::MoveList list;
+    position.generateLegal(list);
+    if (std::find(list.begin(), list.end(), cached) == list.end())
+        return false;
+    m = cached;
+    return true;
+}
+
+void ChessGame::setHint (chess::Move m) {
+    if (m == lastHint)
+        return;
+    lastHint = m;
+    if (observer)
+        observer->hintChanged(*this, m);
+}
+
+UciSession& ChessGame::uci (chess::Color side) {
+    return (*engines)[playerEngine[side]].session;
+}
+
+//engine of side gets the position after the last capture or pawn move followed by
+//the reversible moves, so the command stays short while keeping repetitions visible.
+//The extra move, when given, is played after the current position.
+void ChessGame::sendPosition (chess::Color side, chess::Move extra) {
+    if (!engines || !engines->size())
+        return;
+    uci(side).setSkillLevel(level[side]);
+
+    chess::Position base = position;
+    size_t first = historyPtr - std::min<size_t>(position.halfmoves, historyPtr);
+    for (size_t i = historyPtr; i > first; i--)
+        base.undoMove(moves[i-1], undos[i-1]);
+    std::vector<chess::Move> line(moves.begin(), moves.begin() + historyPtr);
+    if (extra != chess::NoMove)
+        line.push_back(extra);
+    uci(side).setPosition(base, line.data(), first, line.size());
+}
+
+void ChessGame::go (chess::Color side, const std::string& cmd) {
+    if (!engines || !engines->size())
+        return;
+    if (pendingSearches.size() != engines->size()) {
+        pendingSearches.assign(engines->size(), 0);
+        staleSearches.assign(engines->size(), 0);
+    }
+    uci(side).send(cmd);
+    pendingSearches[playerEngine[side]]++;
+}
+
+//every running search is stopped and its bestmove will be ignored
+void ChessGame::stopSearches () {
+    pendingReply    = chess::NoMove;
+    ponderMove      = chess::NoMove;
+    ponderHit       = false;
+    for (size_t e = 0; e < pendingSearches.size(); e++) {
+        if (pendingSearches[e] == staleSearches[e])
+            continue;
+        (*engines)[e].session.send("stop");
+        staleSearches[e] = pendingSearches[e];
+    }
+}
+
+void ChessGame::handleMessage (int engine, const UciMessage& msg) {
+    if (msg.type == UciMessage::ReadyOk) {
+        //the first ready engine starts the game unless a human already moved
+        if (!started && historyPtr == 0) {
+            startTurn();
+        }
+        return;
+    }
+    if (msg.type == UciMessage::BestMove) {
+        if (engine >= (int)pendingSearches.size() || !pendingSearches[engine])
+            return;
+        pendingSearches[engine]--;
+        if (staleSearches[engine]) {
+            staleSearches[engine]--;
+            return;
+        }
+        if (!playerIsAi[position.side] || engine != playerEngine[position.side] || isOver())
+            return;
+
+        chess::Move m = position.parseUci(msg.bestMove);
+        if (m == chess::NoMove) {
+            if (strcmp(msg.bestMove, "(none)")) {
+                std::cerr << "Unexpected move from engine: " << msg.bestMove << std::endl;
+                failed = true;
+            } else
+                termination = position.inCheck() ? chess::Checkmate : chess::Stalemate;
+            startTurn();
+            return;
+        }
+        if (replyCache)
+            replyCache->store(replyKey(goCommand), m);
+        applyMove(m);
+        if (ponder && !hint && !playerIsAi[position.side] && msg.ponder[0])
+            ponderMove = position.parseUci(msg.ponder);
+        startTurn();
+        return;
+    }
+    if (msg.type == UciMessage::Info) {
+        //only searches still running for the human to move give hints
+        if (!hint || playerIsAi[position.side] || engine != playerEngine[position.side] ||
+                engine >= (int)pendingSearches.size() || pendingSearches[engine] == staleSearches[engine] ||
+                !msg.pv[0][0])
+            return;
+        chess::Move m = position.parseUci(msg.pv[0]);
+        if (m == chess::NoMove)
+            return;
+        setHint(m);
+        if (replyCache)
+            replyCache->store(replyKey("go infinite"), m);
+    }
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "position.h"
+#include "enginepool.h"
+#include "replycache.h"
+#include "book.h"
+
+class ChessGame;
+
+//Notified by ChessGame of every change, the game state is already updated when
+//called. Renderers implement it to follow the game, all methods default to nothing.
+class GameObserver {
+public:
+    virtual ~GameObserver () {}
+
+    //back to the start position
+    virtual void gameReset (const ChessGame&) {}
+    //m has been played, position is the one after the move
+    virtual void movePlayed (const ChessGame&, chess::Move) {}
+    //m has been taken back, position is the one before the move
+    virtual void moveTakenBack (const ChessGame&, chess::Move) {}
+    //side to move may play, also called when the game ends
+    virtual void turnStarted (const ChessGame&) {}
+    //engine suggestion for a human player, NoMove to clear it
+    virtual void hintChanged (const ChessGame&, chess::Move) {}
+    virtual void gameEnded (const ChessGame&) {}
+};
+
+//Rules state, move history and engine control of one game, without any rendering
+//so it runs the same with or without a window. Ai players get their moves from
+//the engines of an EnginePool, human moves are given with playMove.
+class ChessGame {
+public:
+    chess::Position             position;
+    chess::Termination          termination = chess::NotTerminated;
+    std::vector<uint64_t>       keyHistory;//keys of the previous positions, for repetitions
+    //game record, 16 bits per ply, entries from historyPtr on are undone moves available for redo
+    std::vector<chess::Move>    moves;
+    std::vector<chess::UndoInfo> undos;//undo informations of moves[i] in undos[i]
+    size_t                      historyPtr  = 0;
+    bool                        failed      = false;//an engine answered a move that is not legal, the game is over
+
+    bool            playerIsAi[2]   = {false,true};
+    uint8_t         level[2]        = {20,0};
+    bool            hint            = false;//search for the human player and report the best move
+    bool            started         = false;//first turn started and game not over
+    std::string     goCommand       = "go movetime 50";
+    bool            ponder          = true;//the ai engine searches the expected human move on the human time
+    std::string     startFen;//position new games start from, empty for the standard one
+
+    EnginePool*     engines         = nullptr;
+    int             playerEngine[2] = {0,0};//pool index of the engine playing or hinting each side
+    GameObserver*   observer        = nullptr;
+    //ai moves and hints already known for a position are taken from it instead of searching
+    ReplyCache*     replyCache      = nullptr;
+    //opening book tried first when an ai is to move
+    OpeningBook*    book            = nullptr;
+
+    //zobrist hash of the current position, equal positions give equal keys
+    uint64_t    positionKey () const    { return position.key; }
+    chess::Color sideToMove () const    { return position.side; }
+    bool        isOver () const         { return termination != chess::NotTerminated || failed; }
+    //winning color on checkmate, -1 otherwise
+    int         winner () const         { return termination == chess::Checkmate ? ~position.side : -1; }
+
+    //back to the start position, the first turn starts when an engine is ready. False
+    //if startFen is invalid, the standard start position is used instead.
+    bool    newGame ();
+    //play a book or cached ai reply and handle at most maxMessages engine messages per engine,
+    //never blocks
+    void    poll (int maxMessages);
+    //play a move of the side to move, then start the next turn
+    void    playMove (chess::Move m);
+    //take back the last move, and the previous one too if it leaves an ai to move
+    void    undo ();
+    void    redo ();
+    void    toggleHint ();
+
+private:
+    std::vector<int>    pendingSearches;//go sent to each engine without bestmove yet
+    std::vector<int>    staleSearches;//pending searches whose bestmove must be ignored
+    chess::Move         lastHint = chess::NoMove;
+    chess::Move         ponderMove  = chess::NoMove;//human move expected by the engine, pondered while the human thinks
+    bool                ponderHit   = false;//the pondered move was played, the ai search already runs
+    chess::Move         pendingReply = chess::NoMove;//book or cached move played on next poll, so these turns never recurse
+
+    void        applyMove (chess::Move m);
+    void        takeBack ();
+    void        startTurn ();
+    void        setHint (chess::Move m);
+    void        startHint ();
+    void        startPonder ();
+    uint64_t    replyKey (const std::string& goCmd) const;
+    bool        findReply (const std::string& goCmd, chess::Move& m);//m unchanged when false
+    UciSession& uci (chess::Color side);
+    void        sendPosition (chess::Color side, chess::Move extra = chess::NoMove);
+    void        go (chess::Color side, const std::string& cmd);
+    void        stopSearches ();
+    void        handleMessage (int engine, const UciMessage& msg);
+};
@@ -0,0 +1,54 @@
+#include <algorithm>
+
+#include "culling.h"
+
+Frustum Frustum::fromMatrix (const glm::mat4& m) {
+    //rows of the matrix, glm is column major
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+        rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    Frustum f;
+    f.planes[0] = rows[3] + rows[0];//left
+    f.planes[1] = rows[3] - rows[0];//right
+    f.planes[2] = rows[3] + rows[1];//bottom
+    f.planes[3] = rows[3] - rows[1];//top
+    f.planes[4] = rows[3] + rows[2];//near
+    f.planes[5] = rows[3] - rows[2];//far
+    for (glm::vec4& p : f.planes)
+        p = p * (1.f / glm::length(glm::vec3(p)));
+    return f;
+}
+
+bool Frustum::intersects (const glm::vec3& center, float radius) const {
+    for (const glm::vec4& p : planes)
+        if (glm::dot(glm::vec3(p), center) + p.w < -radius)
+            return false;
+    return true;
+}
+
+glm::vec4 transformSphere (const glm::mat4& model, const glm::vec4& sphere) {
+    glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(sphere), 1.f));
+    float scale = std::max(std::max(glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1]))),
+                           glm::length(glm::vec3(model[2])));
+    return glm::vec4(center, sphere.w * scale);
+}
+
+bool cullInstances (const Frustum& frustum, const std::vector<CullInstance>& instances,
+                    const std::vector<glm::vec4>& primitiveSpheres,
+                    std::vector<DrawIndexedIndirect>& draws, std::vector<uint32_t>& visible) {
+    for (DrawIndexedIndirect& d : draws)
+        d.instanceCount = 0;
+    for (size_t i = 0; i < instances.size(); i++) {
+        const CullInstance& inst = instances[i];
+        if (inst.primitive >= draws.size() || inst.primitive >= primitiveSpheres.size())
+            return false;
+        glm::vec4 s = transformSphere(inst.model, primitiveSpheres[inst.primitive]);
+        if (s.w <= 0.f || !frustum.intersects(glm::vec3(s), s.w))
+            continue;
+        DrawIndexedIndirect& d = draws[inst.primitive];
+        if (d.firstInstance + d.instanceCount >= visible.size())
+            return false;
+        visible[d.firstInstance + d.instanceCount++] = (uint32_t)i;
+    }
+    return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+//same layout as VkDrawIndexedIndirectCommand, one draw per primitive
+struct DrawIndexedIndirect {
+    uint32_t    indexCount;
+    uint32_t    instanceCount;
+    uint32_t    firstIndex;
+    int32_t     vertexOffset;
+    uint32_t    firstInstance;
+};
+
+//an instance to cull, std430 layout so a storage buffer may take it as is
+struct CullInstance {
+    glm::mat4   model;
+    uint32_t    primitive;
+    uint32_t    pad[3];
+};
+
+//planes of the view frustum, xyz normal pointing inside and w distance
+struct Frustum {
+    glm::vec4   planes[6];
+
+    //from projection * view. The near plane is the one of a -1..1 depth range,
+    //so it is conservative with a 0..1 one.
+    static Frustum  fromMatrix (const glm::mat4& viewProj);
+    bool            intersects (const glm::vec3& center, float radius) const;
+};
+
+//bounding sphere in world space of a model space one (xyz center, w radius),
+//the radius is scaled by the largest scale of model
+glm::vec4 transformSphere (const glm::mat4& model, const glm::vec4& sphere);
+
+//cpu reference of frustum culling: the index of each instance in the frustum is
+//added to visible at the firstInstance of the draw of its primitive, which counts
+//it in instanceCount. Instances scaled to zero are hidden ones and never visible.
+//The order in a draw follows instances. False if an instance has no draw or sphere
+//for its primitive, or if its draw overflows visible.
+bool cullInstances (const Frustum& frustum, const std::vector<CullInstance>& instances,
+                    const std::vector<glm::vec4>& primitiveSpheres,
+                    std::vector<DrawIndexedIndirect>& draws, std::vector<uint32_t>& visible);
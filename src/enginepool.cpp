@@ -0,0 +1,158 @@
+#include <spawn.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <sstream>
+#include <iostream>
+
+#include "enginepool.h"
+
+extern char** environ;
+
+//spawn command with its stdin and stdout/stderr on two new pipes, return the pid or -1
+static pid_t spawnEngine (const std::string& command, int& readFd, int& writeFd) {
+    std::vector<std::string> args;
+    std::istringstream in(command);
+    std::string arg;
+    while (in >> arg)
+        args.push_back(arg);
+    if (args.empty())
+        return -1;
+    std::vector<char*> argv;
+    for (std::string& a : args)
+        argv.push_back(&a[0]);
+    argv.push_back(nullptr);
+
+    int toEngine[2], fromEngine[2];
+    if (pipe(toEngine))
+        return -1;
+    if (pipe(fromEngine)) {
+        close(toEngine[0]);
+        close(toEngine[1]);
+        return -1;
+    }
+    //parent ends must not leak into the engines spawned next or their eof is never seen
+    fcntl(toEngine[1], F_SETFD, FD_CLOEXEC);
+    fcntl(fromEngine[0], F_SETFD, FD_CLOEXEC);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init (&actions);
+    posix_spawn_file_actions_adddup2 (&actions, toEngine[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2 (&actions, fromEngine[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2 (&actions, fromEngine[1], STDERR_FILENO);
+    posix_spawn_file_actions_addclose (&actions, toEngine[0]);
+    posix_spawn_file_actions_addclose (&actions, fromEngine[1]);
+
+    pid_t pid;
+    int err = posix_spawnp (&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy (&actions);
+
+    close(toEngine[0]);
+    close(fromEngine[1]);
+    if (err) {
+        std::cerr << "Unable to start engine '" << command << "': " << strerror(err) << std::endl;
+        close(toEngine[1]);
+        close(fromEngine[0]);
+        return -1;
+    }
+    fcntl(fromEngine[0], F_SETFL, O_NONBLOCK);//set read non blocking
+    readFd  = fromEngine[0];
+    writeFd = toEngine[1];
+    return pid;
+}
+
+int EnginePool::start (const std::string& command, int count) {
+    stop();
+    //a crashed engine must not kill us on the next write
+    signal(SIGPIPE, SIG_IGN);
+
+    int running = 0;
+    for (int i = 0; i < count; i++) {
+        engines.emplace_back(new EngineProcess());
+        EngineProcess& e = *engines.back();
+        if (command == BuiltinEngineCommand) {
+            e.builtin.reset(new BuiltinEngine(e.reader.messages));
+            e.session.sink = e.builtin.get();
+            e.session.send("uci");
+            running++;
+            continue;
+        }
+        e.pid = spawnEngine(command, e.readFd, e.writeFd);
+        if (e.pid < 0)
+            continue;
+        e.session.fd = e.writeFd;
+        e.session.reset();
+        e.reader.start(e.readFd);
+        e.session.send("uci");
+        running++;
+    }
+    return running;
+}
+
+void EnginePool::stop () {
+    for (std::unique_ptr<EngineProcess>& e : engines) {
+        e->builtin.reset();
+        if (e->pid < 0)
+            continue;
+        e->session.send("quit");
+        close(e->writeFd);//eof on stdin also ends engines ignoring quit
+        e->reader.stop();
+        close(e->readFd);
+        waitpid(e->pid, nullptr, 0);
+    }
+    engines.clear();
+    queue.clear();
+}
+
+size_t EnginePool::pending () const {
+    size_t count = queue.size();
+    for (const std::unique_ptr<EngineProcess>& e : engines)
+        if (e->job >= 0)
+            count++;
+    return count;
+}
+
+int EnginePool::poll (std::vector<EngineResult>& results) {
+    int finished = 0;
+    for (size_t i = 0; i < engines.size(); i++) {
+        EngineProcess& e = *engines[i];
+        //taken before draining, messages are all queued once eof is set
+        bool dead = !e.alive();
+
+        UciMessage msg;
+        while (e.reader.messages.pop(msg)) {
+            if (e.job < 0)
+                continue;
+            if (msg.type == UciMessage::Info && msg.hasScore)
+                e.result.info = msg;
+            else if (msg.type == UciMessage::BestMove) {
+                e.result.best = msg;
+                results.push_back(e.result);
+                e.job = -1;
+                finished++;
+            }
+        }
+        if (e.job >= 0 && dead) {
+            //engine died during the search, the job ends without a move
+            results.push_back(e.result);
+            e.job = -1;
+            finished++;
+        }
+        if (e.job >= 0 || queue.empty() || dead)
+            continue;
+
+        const EngineJob& job = queue.front();
+        e.job = job.id;
+        memset (&e.result, 0, sizeof(EngineResult));
+        e.result.id     = job.id;
+        e.result.engine = i;
+        if (job.skillLevel >= 0)
+            e.session.setSkillLevel(job.skillLevel);
+        e.session.send(job.position);
+        e.session.send(job.go);
+        queue.pop_front();
+    }
+    return finished;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <sys/types.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+
+#include "ucisession.h"
+#include "enginethread.h"
+#include "builtinengine.h"
+
+//engine command selecting the in process BuiltinEngine instead of a child process
+const char* const BuiltinEngineCommand = "builtin";
+
+//one search to run on any idle engine of the pool
+struct EngineJob {
+    int         id;
+    std::string position;//full "position ..." command
+    std::string go;//full "go ..." command, must end with a bestmove
+    int         skillLevel = -1;//-1 to keep the engine setting
+};
+struct EngineResult {
+    int         id;
+    int         engine;//index of the engine that ran the job
+    UciMessage  info;//last info line carrying a score, type is Other if none
+    UciMessage  best;//type is Other if the engine died before answering
+};
+
+//One engine child process, written through its session and read by its own thread.
+//A builtin engine has no process, its session sink is the engine and it posts to
+//the reader queue itself.
+struct EngineProcess {
+    pid_t           pid     = -1;
+    int             readFd  = -1;
+    int             writeFd = -1;
+    UciSession      session;
+    EngineThread    reader;
+    std::unique_ptr<BuiltinEngine> builtin;//destroyed before the reader queue it posts to
+
+    int             job     = -1;//id of the running job, -1 if idle
+    EngineResult    result;
+
+    bool alive () const { return builtin || (pid > 0 && !reader.eof()); }
+};
+
+//N engine processes started directly with posix_spawnp, without a shell in
+//between. Engines are used either interactively, by sending through their
+//session and popping their reader messages, or through the job queue where
+//submitted searches go to whichever engine is idle. Both uses must not be
+//mixed on the same engine.
+class EnginePool {
+public:
+    ~EnginePool () { stop(); }
+
+    //command is split on spaces and looked up in PATH, or is BuiltinEngineCommand,
+    //the engines are sent "uci". Return the number of engines actually running.
+    int     start (const std::string& command, int count);
+    //ask every engine to quit and wait for the processes
+    void    stop ();
+
+    size_t          size () const               { return engines.size(); }
+    EngineProcess&  operator[] (size_t i)       { return *engines[i]; }
+
+    void    submit (const EngineJob& job)       { queue.push_back(job); }
+    //jobs queued or running
+    size_t  pending () const;
+    //start queued jobs on idle engines and append the finished ones to results,
+    //never blocks. Return the number of results appended.
+    int     poll (std::vector<EngineResult>& results);
+
+private:
+    std::vector<std::unique_ptr<EngineProcess>> engines;
+    std::deque<EngineJob>                       queue;
+};
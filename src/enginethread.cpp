@@ -0,0 +1,49 @@
+#include <poll.h>
+#include <iostream>
+#include <string>
+#include <chrono>
+
+#include "enginethread.h"
+
+void EngineThread::start (int fd) {
+    stop();
+    reader.reset(fd);
+    endOfFile = false;
+    running = true;
+    thread = std::thread(&EngineThread::run, this);
+}
+void EngineThread::stop () {
+    running = false;
+    if (thread.joinable())
+        thread.join();
+}
+
+void EngineThread::run () {
+    struct pollfd pfd = {reader.fd, POLLIN, 0};
+
+    while (running && !reader.eof) {
+        //short timeout so stop() is never waiting long
+        if (poll(&pfd, 1, 20) <= 0)
+            continue;
+        reader.fill();
+
+        UciMessage msg;
+        while (reader.next(msg)) {
+#if DEBUG_STOCKFISH
+            std::cout << "=> " << std::string(msg.line, msg.length) << std::endl;
+#endif
+            msg.line    = nullptr;
+            msg.length  = 0;
+            if (msg.type == UciMessage::Info) {
+                //a newer one will follow, it is not worth waiting for room
+                if (!messages.push(msg))
+                    droppedInfos++;
+                continue;
+            }
+            while (running && !messages.push(msg))
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    endOfFile = reader.eof;
+    running = false;
+}
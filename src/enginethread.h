@@ -0,0 +1,34 @@
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include <stdint.h>
+
+#include "ucireader.h"
+#include "spscqueue.h"
+
+//Reads and parses engine output on its own thread and posts the messages to a
+//lock free queue, so the frame loop only pops already parsed results.
+class EngineThread {
+public:
+    //parsed messages, line and length are cleared since the reader buffer is reused
+    SpscQueue<UciMessage, 1024> messages;
+    //info lines dropped because the consumer did not keep up
+    std::atomic<uint64_t>       droppedInfos{0};
+
+    ~EngineThread () { stop(); }
+
+    void start (int fd);
+    void stop ();
+    bool isRunning () const { return running; }
+    //the engine closed its output, it exited or crashed
+    bool eof () const { return endOfFile; }
+
+private:
+    std::thread         thread;
+    std::atomic<bool>   running{false};
+    std::atomic<bool>   endOfFile{false};
+    UciReader           reader;
+
+    void run ();
+};
@@ -0,0 +1,106 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "fakeuci.h"
+#include "position.h"
+
+namespace chess {
+
+//captures first, otherwise a move picked from the position key so the game is
+//reproducible without always playing the same first move
+static Move pickMove (const Position& pos) {
+    MoveList list;
+    pos.generateLegal(list);
+    if (!list.size())
+        return NoMove;
+    for (Move m : list)
+        if (isCapture(m))
+            return m;
+    return list[pos.key % list.size()];
+}
+
+void readUciPosition (Position& pos, std::istringstream& in, std::vector<uint64_t>* keys) {
+    std::string tok;
+    in >> tok;
+    if (tok == "startpos") {
+        pos.setStartPosition();
+        in >> tok;
+    } else if (tok == "fen") {
+        std::string fen;
+        while (in >> tok && tok != "moves")
+            fen += (fen.empty() ? "" : " ") + tok;
+        if (!pos.setFen(fen))
+            pos.setStartPosition();
+    }
+    if (keys)
+        keys->clear();
+    if (tok != "moves")
+        return;
+    while (in >> tok) {
+        Move m = pos.parseUci(tok.c_str());
+        if (m == NoMove)
+            break;
+        if (keys)
+            keys->push_back(pos.key);
+        pos.doMove(m);
+    }
+}
+
+static void sendBestMove (const Position& pos) {
+    Move m = pickMove(pos);
+    if (m == NoMove) {
+        std::cout << "info depth 0 score " << (pos.inCheck() ? "mate 0" : "cp 0") << std::endl;
+        std::cout << "bestmove (none)" << std::endl;
+        return;
+    }
+    std::string uci = moveToUci(m);
+    std::cout << "info depth 1 seldepth 1 score cp 0 nodes 1 pv " << uci << std::endl;
+    std::cout << "bestmove " << uci << std::endl;
+}
+
+int runFakeUciEngine () {
+    Position    pos;
+    bool        searching = false;//go infinite pending until stop
+    std::string line;
+
+    while (std::getline(std::cin, line)) {
+        std::istringstream in(line);
+        std::string cmd;
+        in >> cmd;
+
+        if (cmd == "uci")
+            std::cout << "id name vkChess fake engine" << std::endl << "uciok" << std::endl;
+        else if (cmd == "isready")
+            std::cout << "readyok" << std::endl;
+        else if (cmd == "ucinewgame")
+            pos.setStartPosition();
+        else if (cmd == "position")
+            readUciPosition(pos, in);
+        else if (cmd == "go") {
+            //without a limit the search lasts until stop, as in stockfish
+            std::string tok;
+            bool limited = false;
+            while (in >> tok)
+                if (tok == "movetime" || tok == "depth" || tok == "nodes" || tok == "wtime" || tok == "btime")
+                    limited = true;
+            if (limited)
+                sendBestMove(pos);
+            else {
+                Move m = pickMove(pos);
+                if (m != NoMove)
+                    std::cout << "info depth 1 seldepth 1 score cp 0 nodes 1 pv " << moveToUci(m) << std::endl;
+                searching = true;
+            }
+        } else if (cmd == "stop") {
+            if (searching)
+                sendBestMove(pos);
+            searching = false;
+        } else if (cmd == "quit")
+            break;
+        //setoption and unknown commands are ignored
+    }
+    return 0;
+}
+
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <sstream>
+#include <vector>
+#include <stdint.h>
+
+#include "position.h"
+
+namespace chess {
+
+//Minimal uci engine on stdin/stdout standing in for stockfish, so the engine
+//plumbing can be exercised where no real engine is installed. It answers the
+//handshake, tracks the position and replies to go with a legal move chosen
+//without search. Return when quit is received or stdin is closed.
+int runFakeUciEngine ();
+
+//set pos from the arguments of a uci "position" command, keys receives the keys of
+//the positions before pos reached through the move list when not null
+void readUciPosition (Position& pos, std::istringstream& in, std::vector<uint64_t>* keys = nullptr);
+
+}
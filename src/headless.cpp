@@ -0,0 +1,126 @@
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <chrono>
+
+#include "headless.h"
+#include "chessgame.h"
+
+struct HeadlessSlot {
+    EnginePool  engines;
+    ChessGame   game;
+    int         index   = -1;//game number, -1 when idle
+    bool        dead    = false;//an engine exited or hangs, the slot is not used anymore
+    size_t      plies   = 0;//plies played at the last progress check
+    std::chrono::steady_clock::time_point lastMove;
+};
+
+//an engine not answering for that long is considered hung
+static const std::chrono::seconds moveTimeout(60);
+
+static const char* resultString (const ChessGame& game) {
+    if (game.winner() == chess::White)
+        return "1-0";
+    if (game.winner() == chess::Black)
+        return "0-1";
+    return "1/2-1/2";
+}
+
+int runHeadless (const std::string& engineCommand, int games, int jobs, const std::string& startFen) {
+    std::vector<std::unique_ptr<HeadlessSlot>> slots;
+    for (int i = 0; i < jobs && i < games; i++) {
+        slots.emplace_back(new HeadlessSlot());
+        HeadlessSlot& s = *slots.back();
+        if (s.engines.start(engineCommand, 2) != 2)
+            return games;
+        s.game.engines          = &s.engines;
+        s.game.startFen         = startFen;
+        s.game.playerIsAi[0]    = s.game.playerIsAi[1] = true;
+        s.game.level[0]         = s.game.level[1] = 20;
+        s.game.playerEngine[0]  = 0;
+        s.game.playerEngine[1]  = 1;
+    }
+
+    int next = 0, failed = 0;
+    int wins[2] = {}, draws = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    bool playing = true;
+    while (playing) {
+        playing = false;
+        for (std::unique_ptr<HeadlessSlot>& slot : slots) {
+            HeadlessSlot& s = *slot;
+            if (s.dead)
+                continue;
+            if (s.index < 0) {
+                if (next == games)
+                    continue;
+                s.index = next++;
+                if (!s.game.newGame())
+                    return games;
+                s.plies     = 0;
+                s.lastMove  = std::chrono::steady_clock::now();
+            }
+            s.game.poll(64);
+
+            if (!s.engines[0].alive() || !s.engines[1].alive()) {
+                std::cout << "game " << s.index << ": engine died" << std::endl;
+                failed++;
+                s.dead = true;
+                continue;
+            }
+            playing = true;
+            if (!s.game.isOver()) {
+                std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                if (s.game.historyPtr != s.plies) {
+                    s.plies     = s.game.historyPtr;
+                    s.lastMove  = now;
+                } else if (now - s.lastMove > moveTimeout) {
+                    std::cout << "game " << s.index << ": no move after " << moveTimeout.count()
+                              << "s at ply " << s.plies + 1 << std::endl;
+                    failed++;
+                    s.dead = true;
+                }
+                continue;
+            }
+
+            const ChessGame& g = s.game;
+            if (g.failed) {
+                std::cout << "game " << s.index << ": unexpected move at ply " << g.historyPtr + 1 << std::endl;
+                failed++;
+                s.index = -1;
+                continue;
+            }
+            std::cout << "game " << s.index << ": " << resultString(g) << " "
+                      << chess::terminationName(g.termination) << ", " << g.historyPtr << " plies:";
+            for (size_t i = 0; i < g.historyPtr; i++)
+                std::cout << " " << chess::moveToUci(g.moves[i]);
+            std::cout << std::endl;
+
+            if (g.winner() >= 0)
+                wins[g.winner()]++;
+            else
+                draws++;
+            s.index = -1;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    //games never started because every slot died
+    failed += games - next;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << games << " games in " << seconds << "s, white wins " << wins[0] << ", black wins "
+              << wins[1] << ", draws " << draws << ", failed " << failed << std::endl;
+
+    uint64_t commands = 0, bytes = 0, fullGameBytes = 0;
+    for (std::unique_ptr<HeadlessSlot>& slot : slots)
+        for (size_t e = 0; e < slot->engines.size(); e++) {
+            commands        += slot->engines[e].session.commandsSent;
+            bytes           += slot->engines[e].session.bytesSent;
+            fullGameBytes   += slot->engines[e].session.fullGameBytes;
+        }
+    std::cout << "uci: " << commands << " commands, " << bytes << " bytes sent, about " << fullGameBytes
+              << " bytes estimated when resending the whole game" << std::endl;
+    return failed;
+}
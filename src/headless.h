@@ -0,0 +1,10 @@
+#pragma once
+
+#include <string>
+
+//Play engine versus engine games without any window or vulkan device, as fast as
+//the engines answer. jobs games run at once, each with its own pair of engines.
+//One line is printed per game with its result and moves, then a summary.
+//Games start from startFen unless it is empty. Return the number of games that
+//could not be finished.
+int runHeadless (const std::string& engineCommand, int games, int jobs, const std::string& startFen);
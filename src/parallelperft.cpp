@@ -0,0 +1,216 @@
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+
+#include "parallelperft.h"
+#include "perft.h"
+
+namespace chess {
+
+PerftHash::PerftHash (size_t megabytes) {
+    size_t count = 1;
+    while (count * 2 * sizeof(Entry) <= megabytes << 20)
+        count *= 2;
+    entries = std::vector<Entry>(megabytes ? count : 0);
+    for (Entry& e : entries) {
+        e.check.store(0, std::memory_order_relaxed);
+        e.data.store(0, std::memory_order_relaxed);
+    }
+    mask = count - 1;
+}
+
+bool PerftHash::probe (uint64_t key, int depth, uint64_t& nodes) const {
+    if (entries.empty())
+        return false;
+    const Entry& e = entries[key & mask];
+    uint64_t data = e.data.load(std::memory_order_relaxed);
+    if ((e.check.load(std::memory_order_relaxed) ^ data) != key || (int)(data & 0xFF) != depth)
+        return false;
+    nodes = data >> 8;
+    return true;
+}
+void PerftHash::store (uint64_t key, int depth, uint64_t nodes) {
+    if (entries.empty())
+        return;
+    Entry& e = entries[key & mask];
+    //deeper results are worth more, keep them unless the slot is for another position
+    uint64_t old = e.data.load(std::memory_order_relaxed);
+    if ((e.check.load(std::memory_order_relaxed) ^ old) == key && (int)(old & 0xFF) > depth)
+        return;
+    uint64_t data = nodes << 8 | depth;
+    e.check.store(key ^ data, std::memory_order_relaxed);
+    e.data.store(data, std::memory_order_relaxed);
+}
+
+//depth is part of the probe, the same position is found at several depths
+static uint64_t hashedPerft (Position& pos, int depth, PerftHash& hash) {
+    MoveList list;
+    pos.generateLegal (list);
+    if (depth == 1)
+        return list.size();
+    uint64_t nodes = 0;
+    if (hash.probe(pos.key, depth, nodes))
+        return nodes;
+    UndoInfo undo;
+    for (Move m : list) {
+        pos.doMove (m, undo);
+        nodes += hashedPerft (pos, depth - 1, hash);
+        pos.undoMove (m, undo);
+    }
+    hash.store(pos.key, depth, nodes);
+    return nodes;
+}
+
+namespace {
+
+struct PerftTask {
+    Position    pos;
+    int         depth;
+    int         root;//index of the root move the subtree belongs to
+};
+
+//one deque per worker, the owner takes from the back and thieves from the front
+class WorkQueues {
+public:
+    explicit WorkQueues (int count) : queues(count) {}
+
+    void push (int worker, const PerftTask& t) {
+        std::lock_guard<std::mutex> lock(queues[worker].mutex);
+        queues[worker].tasks.push_back(t);
+    }
+    bool take (int worker, PerftTask& t) {
+        Queue& q = queues[worker];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty())
+            return false;
+        t = q.tasks.back();
+        q.tasks.pop_back();
+        return true;
+    }
+    bool steal (int thief, PerftTask& t) {
+        for (size_t i = 1; i < queues.size(); i++) {
+            Queue& q = queues[(thief + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.tasks.empty())
+                continue;
+            t = q.tasks.front();
+            q.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+private:
+    struct Queue {
+        std::mutex              mutex;
+        std::deque<PerftTask>   tasks;
+    };
+    std::vector<Queue> queues;
+};
+
+}
+
+uint64_t parallelPerft (const Position& pos, int depth, int threads, size_t hashMegabytes,
+                        std::vector<PerftDivide>* divide) {
+    if (threads < 1)
+        threads = 1;
+    MoveList rootMoves;
+    pos.generateLegal (rootMoves);
+    if (divide)
+        divide->clear();
+    if (depth <= 1) {
+        if (divide)
+            for (Move m : rootMoves)
+                divide->push_back(PerftDivide{m, 1});
+        return depth == 1 ? rootMoves.size() : 1;
+    }
+
+    PerftHash hash(hashMegabytes);
+    WorkQueues queues(threads);
+    std::vector<std::atomic<uint64_t>> rootNodes(rootMoves.size());
+
+    //root moves alone are too few and too uneven to balance many threads, one more
+    //ply is split when depth allows
+    int split = (depth > 2 && rootMoves.size() < 4 * threads) ? 2 : 1;
+    int next = 0;
+    for (int r = 0; r < rootMoves.size(); r++) {
+        rootNodes[r] = 0;
+        PerftTask t;
+        t.pos = pos;
+        t.pos.doMove(rootMoves[r]);
+        t.depth = depth - 1;
+        t.root = r;
+        if (split == 1) {
+            queues.push(next++ % threads, t);
+            continue;
+        }
+        MoveList replies;
+        t.pos.generateLegal (replies);
+        Position after = t.pos;
+        for (Move m : replies) {
+            t.pos = after;
+            t.pos.doMove(m);
+            t.depth = depth - 2;
+            queues.push(next++ % threads, t);
+        }
+    }
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < threads; w++) {
+        workers.push_back(std::thread([&, w] () {
+            PerftTask t;
+            while (queues.take(w, t) || queues.steal(w, t)) {
+                uint64_t n = t.depth == 0 ? 1 : hashedPerft(t.pos, t.depth, hash);
+                rootNodes[t.root].fetch_add(n, std::memory_order_relaxed);
+            }
+        }));
+    }
+    for (std::thread& t : workers)
+        t.join();
+
+    uint64_t total = 0;
+    for (int r = 0; r < rootMoves.size(); r++) {
+        total += rootNodes[r];
+        if (divide)
+            divide->push_back(PerftDivide{rootMoves[r], rootNodes[r]});
+    }
+    return total;
+}
+
+int runParallelPerftSuite (int maxDepth, int threads) {
+    threads = std::max(1, threads);
+    int errors = 0;
+    uint64_t totalNodes = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (int i=0; i<perftPositionsCount; i++) {
+        const PerftPosition& ref = perftPositions[i];
+        Position pos;
+        if (!pos.setFen(ref.fen)) {
+            std::cerr << ref.name << ": invalid fen" << std::endl;
+            errors++;
+            continue;
+        }
+        int d = std::max(1, std::min(maxDepth, 6));
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        uint64_t nodes = parallelPerft(pos, d, threads, 64);
+        double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        totalNodes += nodes;
+        std::cout << ref.name << " depth " << d << ": " << nodes << " in " << t << "s";
+        if (ref.nodes[d-1] && nodes != ref.nodes[d-1]) {
+            std::cout << " FAILED, expected " << ref.nodes[d-1];
+            errors++;
+        } else
+            std::cout << (ref.nodes[d-1] ? " ok" : " unchecked");
+        std::cout << std::endl;
+    }
+    double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << totalNodes << " nodes in " << t << "s with " << threads << " threads, "
+              << (uint64_t)(totalNodes / t) << " nodes/s" << std::endl;
+    return errors;
+}
+
+}
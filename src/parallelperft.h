@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+#include "position.h"
+
+namespace chess {
+
+//Perft results shared by all threads without locks. Each entry holds the count
+//with the depth in its low bits, and the key xored with that data, so an entry torn
+//by two concurrent writes fails the key check instead of returning a wrong count.
+class PerftHash {
+public:
+    explicit PerftHash (size_t megabytes);
+
+    bool probe (uint64_t key, int depth, uint64_t& nodes) const;
+    void store (uint64_t key, int depth, uint64_t nodes);
+
+private:
+    struct Entry {
+        std::atomic<uint64_t> check;//key ^ data
+        std::atomic<uint64_t> data;//nodes << 8 | depth
+    };
+    std::vector<Entry>  entries;
+    uint64_t            mask;
+};
+
+//nodes below one root move
+struct PerftDivide {
+    Move        move;
+    uint64_t    nodes;
+};
+
+//perft of pos split over threads workers. Subtrees below the first plies are
+//queued on per thread deques, idle workers steal from the others. Counts per root
+//move are returned in divide when not null. hashMegabytes 0 disables the hash.
+uint64_t parallelPerft (const Position& pos, int depth, int threads, size_t hashMegabytes,
+                        std::vector<PerftDivide>* divide = nullptr);
+
+//reference suite with parallelPerft, timed, return the number of mismatches
+int runParallelPerftSuite (int maxDepth, int threads);
+
+}
@@ -0,0 +1,149 @@
+#include <string.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "perft.h"
+#include "position.h"
+
+namespace chess {
+
+//reference counts from https://www.chessprogramming.org/Perft_Results
+const PerftPosition perftPositions[] = {
+    {"start",    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        {20, 400, 8902, 197281, 4865609, 119060324}},
+    {"kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        {48, 2039, 97862, 4085603, 193690690, 8031647685ULL}},
+    {"pos3",     "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        {14, 191, 2812, 43238, 674624, 11030083}},
+    {"pos4",     "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        {6, 264, 9467, 422333, 15833292, 706045033}},
+    {"pos5",     "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        {44, 1486, 62379, 2103487, 89941194, 3048196529ULL}},
+    {"pos6",     "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        {46, 2079, 89890, 3894594, 164075551, 6923051137ULL}},
+};
+const int perftPositionsCount = sizeof(perftPositions) / sizeof(PerftPosition);
+
+static bool selected (const char* name, const std::vector<const char*>& names) {
+    if (names.empty())
+        return true;
+    for (const char* n : names)
+        if (strcmp(n, name) == 0)
+            return true;
+    return false;
+}
+
+int runPerftSuite (int maxDepth, const std::vector<const char*>& names, PerftSuiteStats* stats) {
+    int errors = 0;
+    for (int i=0; i<perftPositionsCount; i++) {
+        const PerftPosition& ref = perftPositions[i];
+        if (!selected(ref.name, names))
+            continue;
+        Position pos;
+        if (!pos.setFen(ref.fen)) {
+            std::cerr << ref.name << ": invalid fen" << std::endl;
+            errors++;
+            continue;
+        }
+        for (int d=1; d<=maxDepth && d<=6 && ref.nodes[d-1]; d++) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            uint64_t nodes = perft(pos, d);
+            double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (stats) {
+                stats->nodes    += nodes;
+                stats->seconds  += t;
+            }
+            bool ok = nodes == ref.nodes[d-1];
+            std::cout << ref.name << " depth " << d << ": " << nodes << " in " << t << "s"
+                      << (ok ? " ok" : " FAILED, expected " + std::to_string(ref.nodes[d-1])) << std::endl;
+            if (!ok)
+                errors++;
+        }
+    }
+    return errors;
+}
+
+int runKeySuite (int games, int maxPlies) {
+    uint64_t rnd = 0x853C49E6748FEA9BULL;
+    int errors = 0, plies = 0;
+
+    for (int g=0; g<games; g++) {
+        Position pos;
+        std::vector<Move> moves;
+        std::vector<UndoInfo> undos;
+        while ((int)moves.size() < maxPlies) {
+            MoveList list;
+            pos.generateLegal (list);
+            if (!list.size())
+                break;
+            rnd ^= rnd << 13; rnd ^= rnd >> 7; rnd ^= rnd << 17;
+            moves.push_back (list[rnd % list.size()]);
+            undos.push_back (UndoInfo());
+            pos.doMove (moves.back(), undos.back());
+            if (pos.key != pos.computeKey()) {
+                std::cerr << "key mismatch after " << moveToUci(moves.back()) << " in " << pos.fen() << std::endl;
+                errors++;
+            }
+        }
+        plies += moves.size();
+        while (!moves.empty()) {
+            pos.undoMove (moves.back(), undos.back());
+            moves.pop_back();
+            undos.pop_back();
+            if (pos.key != pos.computeKey()) {
+                std::cerr << "key mismatch on undo in " << pos.fen() << std::endl;
+                errors++;
+            }
+        }
+        if (pos.key != Position().key)
+            errors++;
+    }
+    std::cout << "zobrist keys: " << games << " random games, " << plies << " plies, "
+              << errors << " mismatches" << std::endl;
+    return errors;
+}
+
+int runFenSuite () {
+    static const char* invalid[] = {
+        "4k3/8/8/8/8/8/8/4K31 w - - 0 1",//rank over 8 files
+        "4k3/8/8/8/8/8/8/4K2 w - - 0 1",//rank under 8 files
+        "4k3/8/8/8/8/8/4K3 w - - 0 1",//7 ranks
+        "4k3/8/8/8/8/8/8/8/4K3 w - - 0 1",//9 ranks
+        "8/8/8/8/8/8/8/4K3 w - - 0 1",//no black king
+        "4k3/8/8/8/8/8/4R3/4K3 w - - 0 1",//side not to move in check
+        "kK6/8/8/8/8/8/8/8 w - - 0 1",//touching kings
+        "4k3/8/8/8/8/8/8/4K3 x - - 0 1",//unknown side
+        "4k3/8/8/8/8/8/8/4K3",//no side
+    };
+    //fen given, expected fen once parsed and its legal move count
+    static const struct { const char* fen; const char* parsed; int moves; } sanitized[] = {
+        {"4k3/8/8/8/8/8/8/4K3 w K - 0 1",           "4k3/8/8/8/8/8/8/4K3 w - - 0 1",        5},
+        {"r3k3/8/8/8/8/8/8/R4K1R w KQkq - 0 1",     "r3k3/8/8/8/8/8/8/R4K1R w q - 0 1",     24},
+        {"4k3/8/8/3pP3/8/8/8/4K3 w - a9 0 1",       "4k3/8/8/3pP3/8/8/8/4K3 w - - 0 1",     6},
+        {"4k3/8/8/3pP3/8/8/8/4K3 w - d3 0 1",       "4k3/8/8/3pP3/8/8/8/4K3 w - - 0 1",     6},
+        {"4k3/8/8/3pP3/8/8/8/4K3 w - f6 0 1",       "4k3/8/8/3pP3/8/8/8/4K3 w - - 0 1",     6},
+        {"4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1",       "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1",    7},
+    };
+    int errors = 0;
+    Position pos;
+    for (const char* fen : invalid) {
+        if (pos.setFen(fen)) {
+            std::cerr << "invalid fen accepted: " << fen << std::endl;
+            errors++;
+        }
+    }
+    for (auto& f : sanitized) {
+        if (!pos.setFen(f.fen) || pos.fen() != f.parsed) {
+            std::cerr << "fen " << f.fen << " parsed as " << pos.fen() << ", expected " << f.parsed << std::endl;
+            errors++;
+        } else if (perft(pos, 1) != (uint64_t)f.moves) {
+            std::cerr << "fen " << f.fen << ": " << perft(pos, 1) << " moves, expected " << f.moves << std::endl;
+            errors++;
+        }
+    }
+    std::cout << "fen parsing: " << errors << " mismatches" << std::endl;
+    return errors;
+}
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+namespace chess {
+
+struct PerftPosition {
+    const char* name;
+    const char* fen;
+    uint64_t    nodes[6];//reference counts for depth 1..6, 0 if unknown
+};
+
+extern const PerftPosition perftPositions[];
+extern const int perftPositionsCount;
+
+//totals of a runPerftSuite call
+struct PerftSuiteStats {
+    uint64_t    nodes   = 0;
+    double      seconds = 0;
+};
+
+//run perft on the reference positions, or on the named ones if names is not empty,
+//for each depth up to maxDepth, print the counts with their time and compare them,
+//return the number of mismatches
+int runPerftSuite (int maxDepth, const std::vector<const char*>& names = std::vector<const char*>(),
+                   PerftSuiteStats* stats = nullptr);
+//play random games and check that the incremental zobrist key matches a key
+//computed from scratch after every move and every take back, return mismatches
+int runKeySuite (int games, int maxPlies);
+//check that malformed fen are rejected and impossible castling or en passant
+//rights are dropped, return mismatches
+int runFenSuite ();
+
+}
@@ -0,0 +1,166 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "pgn.h"
+
+bool MappedFile::open (const char* path) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);//the mapping keeps the file
+    if (p == MAP_FAILED)
+        return false;
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    data = (const char*)p;
+    size = st.st_size;
+    return true;
+}
+void MappedFile::close () {
+    if (data)
+        munmap((void*)data, size);
+    data = nullptr;
+    size = 0;
+}
+
+static bool isSpace (char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+static bool tokenIs (const char* p, const char* end, const char* word) {
+    size_t len = strlen(word);
+    return (size_t)(end - p) >= len && strncmp(p, word, len) == 0 &&
+            (p + len == end || isSpace(p[len]) || strchr("{;()[", p[len]));
+}
+
+void PgnReader::skipSpaces () {
+    while (cur < end && isSpace(*cur))
+        cur++;
+}
+void PgnReader::skipLine () {
+    const char* nl = (const char*)memchr(cur, '\n', end - cur);
+    cur = nl ? nl + 1 : end;
+}
+void PgnReader::skipComment () {
+    const char* close = (const char*)memchr(cur, '}', end - cur);
+    cur = close ? close + 1 : end;
+}
+//variations may nest and hold comments with parenthesis
+void PgnReader::skipVariation () {
+    int depth = 0;
+    while (cur < end) {
+        char c = *cur;
+        if (c == '{') {
+            skipComment();
+            continue;
+        }
+        cur++;
+        if (c == '(')
+            depth++;
+        else if (c == ')' && --depth == 0)
+            return;
+    }
+}
+void PgnReader::readTag (PgnGame& game) {
+    cur++;//[
+    const char* name = cur;
+    while (cur < end && !isSpace(*cur) && *cur != ']')
+        cur++;
+    int nameLength = cur - name;
+    const char* open = (const char*)memchr(cur, '"', end - cur);
+    const char* close = (const char*)memchr(cur, ']', end - cur);
+    if (!close) {
+        cur = end;
+        return;
+    }
+    if (open && open < close) {
+        //value may contain an escaped quote or a ]
+        const char* value = open + 1;
+        const char* p = value;
+        while (p < end && *p != '"')
+            p += (*p == '\\') ? 2 : 1;
+        if (p >= end) {
+            cur = end;
+            return;
+        }
+        if (nameLength == 3 && strncmp(name, "FEN", 3) == 0) {
+            game.fen.str    = value;
+            game.fen.length = p - value;
+        }
+        close = (const char*)memchr(p, ']', end - p);
+        if (!close) {
+            cur = end;
+            return;
+        }
+    }
+    cur = close + 1;
+}
+
+bool PgnReader::next (PgnGame& game) {
+    game.fen = game.result = PgnToken();
+    game.moves.clear();
+    bool inMoves = false;
+
+    while (true) {
+        skipSpaces();
+        if (cur == end)
+            return inMoves || game.moves.size();
+        char c = *cur;
+
+        if (c == '[') {
+            if (inMoves)
+                return true;//next game without result
+            readTag(game);
+        } else if (c == '%' && (cur == begin || cur[-1] == '\n')) {
+            skipLine();//escape line
+        } else if (c == ';') {
+            skipLine();
+        } else if (c == '{') {
+            skipComment();
+        } else if (c == '(') {
+            skipVariation();
+        } else if (c == ')') {
+            cur++;//unbalanced
+        } else if (c == '$') {
+            cur++;
+            while (cur < end && *cur >= '0' && *cur <= '9')
+                cur++;
+        } else {
+            inMoves = true;
+            const char* tok = cur;
+            while (cur < end && !isSpace(*cur) && !strchr("{;()[", *cur))
+                cur++;
+            if (tokenIs(tok, cur, "1-0") || tokenIs(tok, cur, "0-1") ||
+                    tokenIs(tok, cur, "1/2-1/2") || tokenIs(tok, cur, "*")) {
+                game.result.str     = tok;
+                game.result.length  = cur - tok;
+                return true;
+            }
+            //move number, possibly glued to the move as in 12.e4 or 12...e5
+            if (*tok >= '1' && *tok <= '9') {
+                const char* p = tok;
+                while (p < cur && *p >= '0' && *p <= '9')
+                    p++;
+                if (p < cur && *p == '.') {
+                    while (p < cur && *p == '.')
+                        p++;
+                    tok = p;
+                }
+            }
+            if (tok < cur) {
+                PgnToken t;
+                t.str       = tok;
+                t.length    = cur - tok;
+                game.moves.push_back(t);
+            }
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+
+//Read only mapping of a whole file, pages are loaded by the kernel when touched
+//so files larger than memory can be scanned.
+class MappedFile {
+public:
+    const char* data    = nullptr;
+    size_t      size    = 0;
+
+    ~MappedFile () { close(); }
+
+    bool open (const char* path);
+    void close ();
+};
+
+//piece of the input, not null terminated
+struct PgnToken {
+    const char* str     = nullptr;
+    int         length  = 0;
+};
+
+//one game of a pgn file, tokens point into the input buffer
+struct PgnGame {
+    PgnToken                fen;//FEN tag value, empty for the start position
+    PgnToken                result;
+    std::vector<PgnToken>   moves;//san of the main line, comments, variations and nags skipped
+};
+
+//Splits a pgn buffer in games without copying it.
+class PgnReader {
+public:
+    PgnReader (const char* data, size_t size) : begin(data), cur(data), end(data + size) {}
+
+    //false when no game is left
+    bool next (PgnGame& game);
+
+private:
+    const char* begin;
+    const char* cur;
+    const char* end;
+
+    void skipSpaces ();
+    void skipLine ();
+    void skipComment ();
+    void skipVariation ();
+    void readTag (PgnGame& game);
+};
@@ -0,0 +1,620 @@
+#include <string.h>
+#include <ctype.h>
+#include <sstream>
+
+#include "position.h"
+
+namespace chess {
+
+static const char* pceChars = "prnbqk";//indexed by PceType, upper case for white
+static const char* startFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+//castling rights kept when a move starts from or ends on a square
+static uint8_t castlingMask (int sq) {
+    switch (sq) {
+    case A1: return (uint8_t)~WhiteLong;
+    case H1: return (uint8_t)~WhiteShort;
+    case E1: return (uint8_t)~(WhiteShort|WhiteLong);
+    case A8: return (uint8_t)~BlackLong;
+    case H8: return (uint8_t)~BlackShort;
+    case E8: return (uint8_t)~(BlackShort|BlackLong);
+    default: return 0xFF;
+    }
+}
+
+std::string moveToUci (Move m) {
+    std::string s;
+    s += (char)('a' + fileOf(moveFrom(m)));
+    s += (char)('1' + rankOf(moveFrom(m)));
+    s += (char)('a' + fileOf(moveTo(m)));
+    s += (char)('1' + rankOf(moveTo(m)));
+    if (isPromotion(m))
+        s += pceChars[promotionType(m)];
+    return s;
+}
+
+void Position::clear () {
+    memset (pieces, 0, sizeof(pieces));
+    colors[White] = colors[Black] = occupied = 0;
+    key         = 0;
+    memset (board, NoPce, sizeof(board));
+    side        = White;
+    castling    = 0;
+    epSquare    = NoSquare;
+    halfmoves   = 0;
+    fullmoves   = 1;
+}
+void Position::setStartPosition () {
+    initBitboards();
+    setFen (startFen);
+}
+
+bool Position::setFen (const std::string& fen) {
+    clear();
+
+    std::istringstream in(fen);
+    std::string placement, sideStr, castlingStr, epStr;
+    in >> placement >> sideStr >> castlingStr >> epStr;
+
+    int x = 0, y = 7;
+    for (char c : placement) {
+        if (c == '/') {
+            if (x != 8 || --y < 0)
+                return false;
+            x = 0;
+        } else if (c >= '1' && c <= '8') {
+            x += c - '0';
+            if (x > 8)
+                return false;
+        } else {
+            const char* p = strchr(pceChars, tolower(c));
+            if (!p || x > 7)
+                return false;
+            putPiece (isupper(c) ? White : Black, (PceType)(p - pceChars), square(x++, y));
+        }
+    }
+    if (x != 8 || y != 0)
+        return false;
+    if (popCount(pieces[White][King]) != 1 || popCount(pieces[Black][King]) != 1)
+        return false;
+
+    if (sideStr == "w")
+        side = White;
+    else if (sideStr == "b")
+        side = Black;
+    else
+        return false;
+    //kings may not touch and the side that just moved may not be left in check,
+    //else the king could be taken
+    if ((kingAttacks[kingSquare(White)] & pieces[Black][King]) || isSquareAttacked(kingSquare(~side), side))
+        return false;
+
+    for (char c : castlingStr) {
+        switch (c) {
+        case 'K': castling |= WhiteShort; break;
+        case 'Q': castling |= WhiteLong; break;
+        case 'k': castling |= BlackShort; break;
+        case 'q': castling |= BlackLong; break;
+        }
+    }
+    //drop rights whose king or rook left its home square, castling would move a missing piece
+    if (!(pieces[White][King] & bit(E1)))
+        castling &= ~(WhiteShort|WhiteLong);
+    if (!(pieces[Black][King] & bit(E8)))
+        castling &= ~(BlackShort|BlackLong);
+    if (!(pieces[White][Rook] & bit(H1)))
+        castling &= ~WhiteShort;
+    if (!(pieces[White][Rook] & bit(A1)))
+        castling &= ~WhiteLong;
+    if (!(pieces[Black][Rook] & bit(H8)))
+        castling &= ~BlackShort;
+    if (!(pieces[Black][Rook] & bit(A8)))
+        castling &= ~BlackLong;
+
+    //en passant square is only kept if it may be taken, so equal positions hash the same.
+    //It must lie behind a pawn that just made a double push, on rank 6 for white to move.
+    int epRank = (side == White) ? 5 : 2;
+    if (epStr.size() == 2 && epStr[0] >= 'a' && epStr[0] <= 'h' && epStr[1] - '1' == epRank) {
+        int sq      = square(epStr[0] - 'a', epRank);
+        int pushed  = sq + ((side == White) ? -8 : 8);
+        if (!(occupied & bit(sq)) && (pieces[~side][Pawn] & bit(pushed)) &&
+                (pawnAttacks[~side][sq] & pieces[side][Pawn]))
+            epSquare = sq;
+    }
+
+    int half = 0, full = 1;
+    if (in >> half >> full) {
+        halfmoves = half;
+        fullmoves = full;
+    }
+    key = computeKey();
+    updateAttackMaps();
+    return true;
+}
+
+std::string Position::fen () const {
+    std::ostringstream out;
+    for (int y=7; y>=0; y--) {
+        int empty = 0;
+        for (int x=0; x<8; x++) {
+            int sq = square(x,y);
+            if (board[sq] == NoPce) {
+                empty++;
+                continue;
+            }
+            if (empty)
+                out << empty;
+            empty = 0;
+            char c = pceChars[board[sq]];
+            out << (char)(colorOn(sq) == White ? toupper(c) : c);
+        }
+        if (empty)
+            out << empty;
+        if (y)
+            out << '/';
+    }
+    out << (side == White ? " w " : " b ");
+    if (!castling)
+        out << '-';
+    if (castling & WhiteShort)  out << 'K';
+    if (castling & WhiteLong)   out << 'Q';
+    if (castling & BlackShort)  out << 'k';
+    if (castling & BlackLong)   out << 'q';
+    if (epSquare == NoSquare)
+        out << " -";
+    else
+        out << ' ' << (char)('a' + fileOf(epSquare)) << (char)('1' + rankOf(epSquare));
+    out << ' ' << halfmoves << ' ' << fullmoves;
+    return out.str();
+}
+
+uint64_t Position::computeKey () const {
+    uint64_t k = Zobrist::castling[castling];
+    for (int sq=0; sq<64; sq++) {
+        if (board[sq] != NoPce)
+            k ^= Zobrist::psq[colorOn(sq)][board[sq]][sq];
+    }
+    if (epSquare != NoSquare)
+        k ^= Zobrist::epFile[fileOf(epSquare)];
+    if (side == Black)
+        k ^= Zobrist::side;
+    return k;
+}
+
+void Position::putPiece (Color c, PceType t, int sq) {
+    pieces[c][t]    |= bit(sq);
+    colors[c]       |= bit(sq);
+    occupied        |= bit(sq);
+    board[sq]       = t;
+    key             ^= Zobrist::psq[c][t][sq];
+}
+void Position::removePiece (int sq) {
+    Color c = colorOn(sq);
+    key                     ^= Zobrist::psq[c][board[sq]][sq];
+    pieces[c][board[sq]]    ^= bit(sq);
+    colors[c]               ^= bit(sq);
+    occupied                ^= bit(sq);
+    board[sq]               = NoPce;
+}
+void Position::movePiece (int from, int to) {
+    Color c = colorOn(from);
+    Bitboard fromTo = bit(from) | bit(to);
+    key                     ^= Zobrist::psq[c][board[from]][from] ^ Zobrist::psq[c][board[from]][to];
+    pieces[c][board[from]]  ^= fromTo;
+    colors[c]               ^= fromTo;
+    occupied                ^= fromTo;
+    board[to]               = board[from];
+    board[from]             = NoPce;
+}
+
+Bitboard Position::attackersTo (int sq, Bitboard occ) const {
+    return (pawnAttacks[Black][sq] & pieces[White][Pawn])
+         | (pawnAttacks[White][sq] & pieces[Black][Pawn])
+         | (knightAttacks[sq] & (pieces[White][Knight] | pieces[Black][Knight]))
+         | (kingAttacks[sq] & (pieces[White][King] | pieces[Black][King]))
+         | (rookAttacks(sq, occ) & (pieces[White][Rook] | pieces[Black][Rook] |
+                                    pieces[White][Queen] | pieces[Black][Queen]))
+         | (bishopAttacks(sq, occ) & (pieces[White][Bishop] | pieces[Black][Bishop] |
+                                      pieces[White][Queen] | pieces[Black][Queen]));
+}
+
+Bitboard Position::leaperAttacks (Color c) const {
+    Bitboard p = pieces[c][Pawn];
+    Bitboard a = (c == White) ? ((p << 7) & ~FileH) | ((p << 9) & ~FileA)
+                              : ((p >> 9) & ~FileH) | ((p >> 7) & ~FileA);
+    Bitboard b = pieces[c][Knight];
+    while (b)
+        a |= knightAttacks[popLsb(b)];
+    return a | kingAttacks[kingSquare(c)];
+}
+Bitboard Position::sliderAttacks (Color c) const {
+    Bitboard occ = occupied ^ pieces[~c][King];
+    Bitboard a = 0;
+    Bitboard b = pieces[c][Rook] | pieces[c][Queen];
+    while (b)
+        a |= rookAttacks(popLsb(b), occ);
+    b = pieces[c][Bishop] | pieces[c][Queen];
+    while (b)
+        a |= bishopAttacks(popLsb(b), occ);
+    return a;
+}
+void Position::updateAttackMaps (int changed) {
+    for (int c=White; c<=Black; c++) {
+        if (changed & (1 << c))
+            maps.leapers[c] = leaperAttacks((Color)c);
+        maps.all[c] = maps.leapers[c] | sliderAttacks((Color)c);
+    }
+
+    Color   them    = ~side;
+    int     ksq     = kingSquare(side);
+    maps.checkers   = attackersTo(ksq, occupied) & colors[them];
+    maps.pinned     = 0;
+    Bitboard snipers = (rookAttacks(ksq, 0) & (pieces[them][Rook] | pieces[them][Queen])) |
+                       (bishopAttacks(ksq, 0) & (pieces[them][Bishop] | pieces[them][Queen]));
+    while (snipers) {
+        Bitboard b = betweenBB[ksq][popLsb(snipers)] & occupied;
+        if (b && !(b & (b - 1)) && (b & colors[side]))
+            maps.pinned |= b;
+    }
+}
+
+bool Position::isSquareAttacked (int sq, Color by, Bitboard occ, Bitboard candidates) const {
+    Bitboard them = colors[by] & candidates;
+    if ((pawnAttacks[~by][sq] & pieces[by][Pawn] & them) ||
+        (knightAttacks[sq] & pieces[by][Knight] & them) ||
+        (kingAttacks[sq] & pieces[by][King] & them))
+        return true;
+    Bitboard rq = (pieces[by][Rook] | pieces[by][Queen]) & them;
+    if (rq && (rookAttacks(sq, occ) & rq))
+        return true;
+    Bitboard bq = (pieces[by][Bishop] | pieces[by][Queen]) & them;
+    return bq && (bishopAttacks(sq, occ) & bq);
+}
+
+bool Position::isLegal (Move m) const {
+    int     from    = moveFrom(m);
+    int     to      = moveTo(m);
+    int     ksq     = kingSquare(side);
+    Color   them    = ~side;
+
+    if (from == ksq)//attack maps already see through the king
+        return !isAttacked(to, them);
+
+    if (moveFlags(m) == EnPassant) {//rare enough to test the resulting occupancy
+        Bitboard occ = (occupied ^ bit(from) ^ bit(to + ((side == White) ? -8 : 8))) | bit(to);
+        return !isSquareAttacked(ksq, them, occ, occ);
+    }
+    if (maps.checkers) {
+        if (maps.checkers & (maps.checkers - 1))
+            return false;//double check, only the king may move
+        int checker = lsb(maps.checkers);
+        if (!((betweenBB[ksq][checker] | maps.checkers) & bit(to)))
+            return false;
+    }
+    return !isPinned(from) || (lineBB[from][ksq] & bit(to));
+}
+
+static void pushPawnMoves (MoveList& list, int from, int to, int flags) {
+    if (rankOf(to) == 0 || rankOf(to) == 7) {
+        for (int p=3; p>=0; p--)
+            list.push (encodeMove(from, to, (flags & Capture) | Promotion | p));
+    } else
+        list.push (encodeMove(from, to, flags));
+}
+static void pushMoves (MoveList& list, int from, Bitboard targets, Bitboard them) {
+    while (targets) {
+        int to = popLsb(targets);
+        list.push (encodeMove(from, to, (them & bit(to)) ? Capture : Quiet));
+    }
+}
+
+void Position::generatePseudoLegal (MoveList& list) const {
+    Color       us      = side;
+    Color       them    = ~side;
+    Bitboard    empty   = ~occupied;
+    Bitboard    targets = ~colors[us];
+    int         forward = (us == White) ? 8 : -8;
+
+    //pawns
+    Bitboard pawns  = pieces[us][Pawn];
+    Bitboard single = (us == White) ? (pawns << 8) & empty : (pawns >> 8) & empty;
+    Bitboard dbl    = (us == White) ? ((single & (Rank1 << 16)) << 8) & empty
+                                    : ((single & (Rank8 >> 16)) >> 8) & empty;
+    while (single) {
+        int to = popLsb(single);
+        pushPawnMoves (list, to - forward, to, Quiet);
+    }
+    while (dbl) {
+        int to = popLsb(dbl);
+        list.push (encodeMove(to - 2 * forward, to, DoublePush));
+    }
+    Bitboard b = pawns;
+    while (b) {
+        int from = popLsb(b);
+        Bitboard caps = pawnAttacks[us][from] & colors[them];
+        while (caps)
+            pushPawnMoves (list, from, popLsb(caps), Capture);
+    }
+    if (epSquare != NoSquare) {
+        b = pawnAttacks[them][epSquare] & pawns;
+        while (b)
+            list.push (encodeMove(popLsb(b), epSquare, EnPassant));
+    }
+
+    //pieces
+    b = pieces[us][Knight];
+    while (b) {
+        int from = popLsb(b);
+        pushMoves (list, from, knightAttacks[from] & targets, colors[them]);
+    }
+    b = pieces[us][Bishop] | pieces[us][Queen];
+    while (b) {
+        int from = popLsb(b);
+        pushMoves (list, from, bishopAttacks(from, occupied) & targets, colors[them]);
+    }
+    b = pieces[us][Rook] | pieces[us][Queen];
+    while (b) {
+        int from = popLsb(b);
+        pushMoves (list, from, rookAttacks(from, occupied) & targets, colors[them]);
+    }
+    int ksq = kingSquare(us);
+    pushMoves (list, ksq, kingAttacks[ksq] & targets, colors[them]);
+
+    //castling, king may not be in check nor pass through an attacked square
+    uint8_t shortRight  = (us == White) ? WhiteShort : BlackShort;
+    uint8_t longRight   = (us == White) ? WhiteLong : BlackLong;
+    if (!(castling & (shortRight | longRight)) || inCheck())
+        return;
+    if ((castling & shortRight) && !(occupied & (bit(ksq+1) | bit(ksq+2))) &&
+            !isAttacked(ksq+1, them))
+        list.push (encodeMove(ksq, ksq+2, ShortCastle));
+    if ((castling & longRight) && !(occupied & (bit(ksq-1) | bit(ksq-2) | bit(ksq-3))) &&
+            !isAttacked(ksq-1, them))
+        list.push (encodeMove(ksq, ksq-2, LongCastle));
+}
+
+void Position::generateLegal (MoveList& list) const {
+    MoveList pseudo;
+    generatePseudoLegal (pseudo);
+    for (Move m : pseudo) {
+        if (isLegal(m))
+            list.push (m);
+    }
+}
+
+Move Position::findMove (int from, int to, PceType promotion) const {
+    if (promotion == NoPce)
+        promotion = Queen;//default to queen if promotion is not specified
+    MoveList list;
+    generateLegal (list);
+    for (Move m : list) {
+        if (moveFrom(m) != from || moveTo(m) != to)
+            continue;
+        if (!isPromotion(m) || promotionType(m) == promotion)
+            return m;
+    }
+    return NoMove;
+}
+Move Position::parseUci (const char* uci) const {
+    if (uci[0] < 'a' || uci[0] > 'h' || uci[1] < '1' || uci[1] > '8' ||
+        uci[2] < 'a' || uci[2] > 'h' || uci[3] < '1' || uci[3] > '8')
+        return NoMove;
+    PceType promotion = NoPce;
+    const char* p = uci[4] ? strchr(pceChars, uci[4]) : nullptr;
+    if (p)
+        promotion = (PceType)(p - pceChars);
+    return findMove (square(uci[0]-'a', uci[1]-'1'), square(uci[2]-'a', uci[3]-'1'), promotion);
+}
+Move Position::parseSan (const char* san, int length) const {
+    while (length && strchr("+#!?", san[length-1]))
+        length--;
+    if (length < 2)
+        return NoMove;
+
+    MoveList list;
+    generateLegal (list);
+
+    if (san[0] == 'O' || san[0] == '0') {
+        int flag = (length == 5) ? LongCastle : (length == 3) ? ShortCastle : -1;
+        for (Move m : list)
+            if (moveFlags(m) == flag)
+                return m;
+        return NoMove;
+    }
+
+    static const char*      sanPieces = "NBRQK";
+    static const PceType    sanTypes[] = {Knight, Bishop, Rook, Queen, King};
+    PceType type = Pawn;
+    const char* p = strchr(sanPieces, san[0]);
+    if (p) {
+        type = sanTypes[p - sanPieces];
+        san++;
+        length--;
+    }
+    PceType promotion = NoPce;
+    if (length > 2 && san[length-1] != 'K' && (p = strchr(sanPieces, san[length-1]))) {
+        promotion = sanTypes[p - sanPieces];
+        length -= san[length-2] == '=' ? 2 : 1;
+    }
+    if (length < 2)
+        return NoMove;
+    char toFile = san[length-2], toRank = san[length-1];
+    if (toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8')
+        return NoMove;
+    int to = square(toFile - 'a', toRank - '1');
+
+    //disambiguation, capture sign ignored
+    int fromFile = -1, fromRank = -1;
+    for (int i = 0; i < length - 2; i++) {
+        if (san[i] >= 'a' && san[i] <= 'h')
+            fromFile = san[i] - 'a';
+        else if (san[i] >= '1' && san[i] <= '8')
+            fromRank = san[i] - '1';
+    }
+
+    Move found = NoMove;
+    for (Move m : list) {
+        int from = moveFrom(m);
+        if (moveTo(m) != to || pieceOn(from) != type || promotionType(m) != promotion)
+            continue;
+        if ((fromFile >= 0 && fileOf(from) != fromFile) || (fromRank >= 0 && rankOf(from) != fromRank))
+            continue;
+        if (found != NoMove)
+            return NoMove;//ambiguous
+        found = m;
+    }
+    return found;
+}
+
+void Position::doMove (Move m, UndoInfo& undo) {
+    int     from    = moveFrom(m);
+    int     to      = moveTo(m);
+    int     flags   = moveFlags(m);
+    Color   us      = side;
+    PceType pt      = pieceOn(from);
+
+    undo.captured   = (flags == EnPassant) ? Pawn : pieceOn(to);
+    undo.castling   = castling;
+    undo.epSquare   = epSquare;
+    undo.halfmoves  = halfmoves;
+    undo.key        = key;
+    undo.maps       = maps;
+
+    key ^= Zobrist::castling[castling] ^ Zobrist::side;
+    if (epSquare != NoSquare)
+        key ^= Zobrist::epFile[fileOf(epSquare)];
+    epSquare = NoSquare;
+    halfmoves++;
+
+    if (flags == EnPassant)
+        removePiece (to + ((us == White) ? -8 : 8));
+    else if (flags & Capture)
+        removePiece (to);
+
+    movePiece (from, to);
+
+    if (flags & Promotion) {
+        removePiece (to);
+        putPiece (us, promotionType(m), to);
+    } else if (flags == ShortCastle)
+        movePiece (to + 1, to - 1);
+    else if (flags == LongCastle)
+        movePiece (to - 2, to + 1);
+    else if (flags == DoublePush && (pawnAttacks[us][(from + to) / 2] & pieces[~us][Pawn])) {
+        epSquare = (from + to) / 2;
+        key ^= Zobrist::epFile[fileOf(epSquare)];
+    }
+
+    if (pt == Pawn || (flags & Capture))
+        halfmoves = 0;
+    castling &= castlingMask(from) & castlingMask(to);
+    key ^= Zobrist::castling[castling];
+    if (us == Black)
+        fullmoves++;
+    side = ~us;
+
+    //leapers only change for the mover, unless a slider moved, and for a captured leaper
+    int changed = 0;
+    if (pt != Rook && pt != Bishop && pt != Queen)
+        changed |= 1 << us;
+    if (undo.captured == Pawn || undo.captured == Knight)
+        changed |= 1 << ~us;
+    updateAttackMaps (changed);
+}
+
+void Position::undoMove (Move m, const UndoInfo& undo) {
+    int     from    = moveFrom(m);
+    int     to      = moveTo(m);
+    int     flags   = moveFlags(m);
+    Color   us      = ~side;
+
+    if (flags & Promotion) {
+        removePiece (to);
+        putPiece (us, Pawn, to);
+    } else if (flags == ShortCastle)
+        movePiece (to - 1, to + 1);
+    else if (flags == LongCastle)
+        movePiece (to + 1, to - 2);
+
+    movePiece (to, from);
+
+    if (flags == EnPassant)
+        putPiece (side, Pawn, to + ((us == White) ? -8 : 8));
+    else if (undo.captured != NoPce)
+        putPiece (side, undo.captured, to);
+
+    castling    = undo.castling;
+    epSquare    = undo.epSquare;
+    halfmoves   = undo.halfmoves;
+    key         = undo.key;
+    maps        = undo.maps;
+    if (us == Black)
+        fullmoves--;
+    side = us;
+}
+
+const char* terminationName (Termination t) {
+    switch (t) {
+    case Checkmate:             return "checkmate";
+    case Stalemate:             return "stalemate";
+    case ThreefoldRepetition:   return "threefold repetition";
+    case FiftyMoveRule:         return "50 moves rule";
+    case InsufficientMaterial:  return "insufficient material";
+    default:                    return "";
+    }
+}
+
+bool hasInsufficientMaterial (const Position& pos) {
+    for (int c=White; c<=Black; c++) {
+        if (pos.pieces[c][Pawn] | pos.pieces[c][Rook] | pos.pieces[c][Queen])
+            return false;
+    }
+    Bitboard knights = pos.pieces[White][Knight] | pos.pieces[Black][Knight];
+    Bitboard bishops = pos.pieces[White][Bishop] | pos.pieces[Black][Bishop];
+    if (!bishops)
+        return popCount(knights) <= 1;//K vs K or KN vs K
+    if (knights)
+        return false;
+    //any number of bishops all standing on the same square color
+    const Bitboard darkSquares = 0xAA55AA55AA55AA55ULL;
+    return !(bishops & darkSquares) || !(bishops & ~darkSquares);
+}
+
+Termination checkTermination (const Position& pos, const uint64_t* history, int historySize) {
+    MoveList list;
+    pos.generateLegal (list);
+    if (!list.size())
+        return pos.inCheck() ? Checkmate : Stalemate;
+    if (pos.halfmoves >= 100)
+        return FiftyMoveRule;
+    if (hasInsufficientMaterial(pos))
+        return InsufficientMaterial;
+
+    //same side to move positions since the last capture or pawn move
+    int repetitions = 1;
+    int first = historySize - pos.halfmoves;
+    for (int i=historySize-2; i>=0 && i>=first; i-=2) {
+        if (history[i] == pos.key && ++repetitions == 3)
+            return ThreefoldRepetition;
+    }
+    return NotTerminated;
+}
+
+uint64_t perft (Position& pos, int depth) {
+    if (depth == 0)
+        return 1;
+    MoveList list;
+    pos.generateLegal (list);
+    if (depth == 1)
+        return list.size();
+    uint64_t nodes = 0;
+    UndoInfo undo;
+    for (Move m : list) {
+        pos.doMove (m, undo);
+        nodes += perft (pos, depth - 1);
+        pos.undoMove (m, undo);
+    }
+    return nodes;
+}
+
+}
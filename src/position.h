@@ -0,0 +1,161 @@
+#pragma once
+
+#include <string>
+
+#include "bitboard.h"
+
+namespace chess {
+
+//16 bits move: from (6 bits), to (6 bits), flags (4 bits)
+typedef uint16_t Move;
+
+enum MoveFlag {
+    Quiet       = 0,
+    DoublePush  = 1,
+    ShortCastle = 2,
+    LongCastle  = 3,
+    Capture     = 4,
+    EnPassant   = 5,
+    Promotion   = 8,//+ 0..3 for knight, bishop, rook, queen, + Capture if taking
+};
+
+enum CastlingRight {
+    WhiteShort  = 1,
+    WhiteLong   = 2,
+    BlackShort  = 4,
+    BlackLong   = 8,
+};
+
+const Move NoMove = 0;
+
+inline Move encodeMove (int from, int to, int flags = Quiet) {
+    return (Move)(from | (to << 6) | (flags << 12));
+}
+inline int  moveFrom (Move m)       { return m & 63; }
+inline int  moveTo (Move m)         { return (m >> 6) & 63; }
+inline int  moveFlags (Move m)      { return m >> 12; }
+inline bool isCapture (Move m)      { return (m >> 12) & Capture; }
+inline bool isPromotion (Move m)    { return (m >> 12) & Promotion; }
+inline bool isCastling (Move m)     { return moveFlags(m) == ShortCastle || moveFlags(m) == LongCastle; }
+inline PceType promotionType (Move m) {
+    static const PceType types[4] = {Knight, Bishop, Rook, Queen};
+    return isPromotion(m) ? types[moveFlags(m) & 3] : NoPce;
+}
+std::string moveToUci (Move m);
+
+//fixed capacity move buffer, 218 is the maximum number of legal moves in a chess position
+struct MoveList {
+    Move    moves[256];
+    int     count = 0;
+
+    inline void push (Move m)               { moves[count++] = m; }
+    inline void clear ()                    { count = 0; }
+    inline int  size () const               { return count; }
+    inline Move operator[] (int i) const    { return moves[i]; }
+    inline const Move* begin () const       { return moves; }
+    inline const Move* end () const         { return moves + count; }
+};
+
+//attack bitmaps refreshed by doMove, so king safety queries are simple lookups
+struct AttackMaps {
+    Bitboard    leapers[2];//squares attacked by pawns, knights and king of each color
+    Bitboard    all[2];//all attacked squares, sliders see through the opposing king
+    Bitboard    checkers;//pieces giving check to the side to move
+    Bitboard    pinned;//pieces of the side to move pinned on their king
+};
+
+//state lost by doMove, needed to take the move back
+struct UndoInfo {
+    PceType     captured;
+    uint8_t     castling;
+    int8_t      epSquare;
+    uint16_t    halfmoves;
+    uint64_t    key;
+    AttackMaps  maps;
+};
+
+struct Position {
+    Bitboard    pieces[2][6];
+    Bitboard    colors[2];
+    Bitboard    occupied;
+    uint8_t     board[64];//PceType or NoPce
+
+    Color       side;
+    uint8_t     castling;
+    int8_t      epSquare;
+    uint16_t    halfmoves;
+    uint16_t    fullmoves;
+
+    uint64_t    key;//zobrist hash, updated incrementally by doMove
+    AttackMaps  maps;
+
+    Position () { setStartPosition(); }
+
+    void clear ();
+    void setStartPosition ();
+    bool setFen (const std::string& fen);
+    std::string fen () const;
+    //zobrist hash computed from scratch
+    uint64_t computeKey () const;
+
+    inline PceType pieceOn (int sq) const   { return (PceType)board[sq]; }
+    inline Color colorOn (int sq) const     { return (colors[Black] & bit(sq)) ? Black : White; }
+    inline int kingSquare (Color c) const   { return lsb(pieces[c][King]); }
+
+    Bitboard attackersTo (int sq, Bitboard occ) const;
+    //test if a piece of 'by' among 'candidates' attacks sq, sliders are blocked by occ
+    bool isSquareAttacked (int sq, Color by, Bitboard occ, Bitboard candidates) const;
+    inline bool isSquareAttacked (int sq, Color by) const {
+        return isSquareAttacked(sq, by, occupied, ~0ULL);
+    }
+    inline bool isAttacked (int sq, Color by) const { return maps.all[by] & bit(sq); }
+    inline bool inCheck () const                    { return maps.checkers != 0; }
+    inline bool isPinned (int sq) const             { return maps.pinned & bit(sq); }
+    //pseudo legal move does not leave own king in check
+    bool isLegal (Move m) const;
+
+    void generatePseudoLegal (MoveList& list) const;
+    void generateLegal (MoveList& list) const;
+    //return the legal move matching the given squares, NoMove if none
+    Move findMove (int from, int to, PceType promotion = NoPce) const;
+    Move parseUci (const char* uci) const;
+    //standard algebraic notation as found in pgn, without null termination, NoMove if
+    //not legal or ambiguous. Check, annotation and castling with zeros are accepted.
+    Move parseSan (const char* san, int length) const;
+
+    void doMove (Move m, UndoInfo& undo);
+    void undoMove (Move m, const UndoInfo& undo);
+    inline void doMove (Move m) {
+        UndoInfo undo;
+        doMove (m, undo);
+    }
+
+    Bitboard leaperAttacks (Color c) const;
+    Bitboard sliderAttacks (Color c) const;
+    //refresh attack maps after pieces of 'changed' colors moved, 0:none, 1:white, 2:black, 3:both
+    void updateAttackMaps (int changed = 3);
+
+    void putPiece (Color c, PceType t, int sq);
+    void removePiece (int sq);
+    void movePiece (int from, int to);
+};
+
+enum Termination {
+    NotTerminated,
+    Checkmate,
+    Stalemate,
+    ThreefoldRepetition,
+    FiftyMoveRule,
+    InsufficientMaterial,
+};
+inline bool isDraw (Termination t) { return t > Checkmate; }
+const char* terminationName (Termination t);
+
+bool hasInsufficientMaterial (const Position& pos);
+//evaluate game end for the side to move, history holds the keys of the previous
+//positions of the game in order, it is used for repetition detection.
+Termination checkTermination (const Position& pos, const uint64_t* history, int historySize);
+
+uint64_t perft (Position& pos, int depth);
+
+}
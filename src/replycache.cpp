@@ -0,0 +1,70 @@
+#include <fstream>
+#include <string.h>
+
+#include "replycache.h"
+
+static const char fileMagic[8] = {'v','k','R','e','p','l','y','1'};
+
+uint64_t ReplyCache::key (uint64_t positionKey, int skillLevel, const std::string& goCommand) {
+    //fnv-1a, stable between runs unlike std::hash, as keys are saved
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (char c : goCommand)
+        h = (h ^ (uint8_t)c) * 0x100000001B3ULL;
+    h = (h ^ (uint8_t)skillLevel) * 0x100000001B3ULL;
+    return positionKey ^ (h * 0x9E3779B97F4A7C15ULL);
+}
+
+bool ReplyCache::find (uint64_t key, chess::Move& move) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        misses++;
+        return false;
+    }
+    entries.splice(entries.begin(), entries, it->second);
+    move = it->second->move;
+    hits++;
+    return true;
+}
+
+void ReplyCache::store (uint64_t key, chess::Move move) {
+    auto it = index.find(key);
+    if (it != index.end()) {
+        it->second->move = move;
+        entries.splice(entries.begin(), entries, it->second);
+        return;
+    }
+    if (entries.size() >= capacity) {
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+    entries.push_front({key, move});
+    index[key] = entries.begin();
+}
+
+void ReplyCache::clear () {
+    entries.clear();
+    index.clear();
+}
+
+//file is the magic followed by key and move pairs, least recent first
+bool ReplyCache::load (const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[8];
+    if (!in.read(magic, 8) || memcmp(magic, fileMagic, 8))
+        return false;
+    uint64_t    key;
+    chess::Move move;
+    while (in.read((char*)&key, sizeof(key)) && in.read((char*)&move, sizeof(move)))
+        store(key, move);
+    return true;
+}
+
+bool ReplyCache::save (const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(fileMagic, 8);
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        out.write((const char*)&it->key, sizeof(it->key));
+        out.write((const char*)&it->move, sizeof(it->move));
+    }
+    return (bool)out;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <list>
+#include <unordered_map>
+
+#include "position.h"
+
+//Least recently used cache of engine best moves. Keys mix the position hash with
+//the skill level and the go command, so a reply is only reused for the same kind
+//of search. It can be saved to and loaded from a file to survive restarts.
+class ReplyCache {
+public:
+    uint64_t    hits    = 0;
+    uint64_t    misses  = 0;
+
+    explicit ReplyCache (size_t capacity = 65536) : capacity(capacity) {}
+
+    static uint64_t key (uint64_t positionKey, int skillLevel, const std::string& goCommand);
+
+    //true and the cached move if key is known, the entry becomes the most recent
+    bool    find (uint64_t key, chess::Move& move);
+    //add or refresh an entry, the least recently used one is dropped when full
+    void    store (uint64_t key, chess::Move move);
+    size_t  size () const   { return entries.size(); }
+    void    clear ();
+
+    //entries of the file are added to the cache, false if it can not be read
+    bool    load (const std::string& path);
+    bool    save (const std::string& path) const;
+
+private:
+    struct Entry {
+        uint64_t    key;
+        chess::Move move;
+    };
+    size_t                  capacity;
+    std::list<Entry>        entries;//most recent first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+};
@@ -0,0 +1,425 @@
+#include <string.h>
+#include <algorithm>
+
+#include "search.h"
+
+namespace chess {
+
+static const int pieceValues[6] = {100, 500, 320, 330, 900, 0};
+
+//piece square bonuses from white's side, rank 8 on the first row, in PceType order
+static const int8_t pieceSquares[6][64] = {
+    {//pawn
+      0,  0,  0,  0,  0,  0,  0,  0,
+     50, 50, 50, 50, 50, 50, 50, 50,
+     10, 10, 20, 30, 30, 20, 10, 10,
+      5,  5, 10, 25, 25, 10,  5,  5,
+      0,  0,  0, 20, 20,  0,  0,  0,
+      5, -5,-10,  0,  0,-10, -5,  5,
+      5, 10, 10,-20,-20, 10, 10,  5,
+      0,  0,  0,  0,  0,  0,  0,  0},
+    {//rook
+      0,  0,  0,  0,  0,  0,  0,  0,
+      5, 10, 10, 10, 10, 10, 10,  5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+     -5,  0,  0,  0,  0,  0,  0, -5,
+      0,  0,  0,  5,  5,  0,  0,  0},
+    {//knight
+    -50,-40,-30,-30,-30,-30,-40,-50,
+    -40,-20,  0,  0,  0,  0,-20,-40,
+    -30,  0, 10, 15, 15, 10,  0,-30,
+    -30,  5, 15, 20, 20, 15,  5,-30,
+    -30,  0, 15, 20, 20, 15,  0,-30,
+    -30,  5, 10, 15, 15, 10,  5,-30,
+    -40,-20,  0,  5,  5,  0,-20,-40,
+    -50,-40,-30,-30,-30,-30,-40,-50},
+    {//bishop
+    -20,-10,-10,-10,-10,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5, 10, 10,  5,  0,-10,
+    -10,  5,  5, 10, 10,  5,  5,-10,
+    -10,  0, 10, 10, 10, 10,  0,-10,
+    -10, 10, 10, 10, 10, 10, 10,-10,
+    -10,  5,  0,  0,  0,  0,  5,-10,
+    -20,-10,-10,-10,-10,-10,-10,-20},
+    {//queen
+    -20,-10,-10, -5, -5,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5,  5,  5,  5,  0,-10,
+     -5,  0,  5,  5,  5,  5,  0, -5,
+      0,  0,  5,  5,  5,  5,  0, -5,
+    -10,  5,  5,  5,  5,  5,  0,-10,
+    -10,  0,  5,  0,  0,  0,  0,-10,
+    -20,-10,-10, -5, -5,-10,-10,-20},
+    {//king, middle game
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -20,-30,-30,-40,-40,-30,-30,-20,
+    -10,-20,-20,-20,-20,-20,-20,-10,
+     20, 20,  0,  0,  0,  0, 20, 20,
+     20, 30, 10,  0,  0, 10, 30, 20},
+};
+//the king walks to the center once the heavy pieces are gone
+static const int8_t kingEndgame[64] = {
+    -50,-40,-30,-20,-20,-30,-40,-50,
+    -30,-20,-10,  0,  0,-10,-20,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-30,  0,  0,  0,  0,-30,-30,
+    -50,-30,-30,-30,-30,-30,-30,-50};
+//weight of each piece type in the game phase, 24 with all pieces on the board
+static const int phaseWeights[6] = {0, 2, 1, 1, 4, 0};
+
+int evaluate (const Position& pos) {
+    int score[2] = {0, 0};
+    int kingMiddle[2] = {0, 0}, kingEnd[2] = {0, 0};
+    int phase = 0;
+    for (int c = White; c <= Black; c++) {
+        //tables are from white's side, black squares are mirrored vertically
+        int flip = c == White ? 56 : 0;
+        for (int t = Pawn; t < King; t++) {
+            Bitboard b = pos.pieces[c][t];
+            phase += popCount(b) * phaseWeights[t];
+            while (b) {
+                int sq = popLsb(b);
+                score[c] += pieceValues[t] + pieceSquares[t][sq ^ flip];
+            }
+        }
+        int king = pos.kingSquare((Color)c) ^ flip;
+        kingMiddle[c]   = pieceSquares[King][king];
+        kingEnd[c]      = kingEndgame[king];
+    }
+    phase = std::min(phase, 24);
+    for (int c = White; c <= Black; c++)
+        score[c] += (kingMiddle[c] * phase + kingEnd[c] * (24 - phase)) / 24;
+
+    int s = score[White] - score[Black];
+    return pos.side == White ? s : -s;
+}
+
+//mate scores are stored relative to the node so they stay valid at any ply
+static int scoreToTT (int score, int ply) {
+    return score > MateScore - MaxPly ? score + ply : score < -MateScore + MaxPly ? score - ply : score;
+}
+static int scoreFromTT (int score, int ply) {
+    return score > MateScore - MaxPly ? score - ply : score < -MateScore + MaxPly ? score + ply : score;
+}
+
+Searcher::Searcher (size_t hashMegabytes) {
+    size_t count = 1;
+    while (count * 2 * sizeof(TTEntry) <= hashMegabytes << 20)
+        count *= 2;
+    table.resize(count);
+    mask = count - 1;
+    clear();
+}
+
+void Searcher::clear () {
+    memset (table.data(), 0, table.size() * sizeof(TTEntry));
+    memset (killers, 0, sizeof(killers));
+    memset (historyScores, 0, sizeof(historyScores));
+}
+
+int Searcher::elapsed () const {
+    return (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - startTime).count();
+}
+
+//true until ponderhit. Time spent pondering counts, so a hit is answered at once
+//when the movetime already passed.
+bool Searcher::isPondering () {
+    if (pondering && ponderhit)
+        pondering = false;
+    return pondering;
+}
+
+//limits are only enforced once a first iteration gave a move to play
+bool Searcher::checkLimits () {
+    if (!completedDepth || isPondering())
+        return false;
+    if (maxNodes && nodes >= maxNodes)
+        return true;
+    return timeLimited && std::chrono::steady_clock::now() >= deadline;
+}
+
+bool Searcher::isRepetition (const Position& pos) const {
+    int first = (int)keys.size() - pos.halfmoves;
+    for (int i = (int)keys.size() - 2; i >= 0 && i >= first; i -= 2)
+        if (keys[i] == pos.key)
+            return true;
+    return false;
+}
+
+void Searcher::orderMoves (const Position& pos, MoveList& list, int* scores, Move ttMove, int ply) const {
+    for (int i = 0; i < list.size(); i++) {
+        Move m = list[i];
+        int s;
+        if (m == ttMove)
+            s = 1 << 30;
+        else if (isCapture(m) || isPromotion(m)) {
+            //most valuable victim first, least valuable attacker among equal victims
+            PceType victim = moveFlags(m) == EnPassant ? Pawn : pos.pieceOn(moveTo(m));
+            s = (1 << 20) + (victim == NoPce ? 0 : pieceValues[victim]) * 8 + pieceValues[promotionType(m) == NoPce ? Pawn : promotionType(m)]
+                - pieceValues[pos.pieceOn(moveFrom(m))] / 100;
+        } else if (m == killers[ply][0])
+            s = (1 << 19) + 1;
+        else if (m == killers[ply][1])
+            s = 1 << 19;
+        else
+            s = std::min(historyScores[pos.side][moveFrom(m)][moveTo(m)], (1 << 19) - 1);
+        scores[i] = s;
+    }
+}
+
+//bring the best scored remaining move to i
+static void pickNext (MoveList& list, int* scores, int i) {
+    int best = i;
+    for (int j = i + 1; j < list.size(); j++)
+        if (scores[j] > scores[best])
+            best = j;
+    std::swap(list.moves[i], list.moves[best]);
+    std::swap(scores[i], scores[best]);
+}
+
+int Searcher::quiesce (Position& pos, int ply, int alpha, int beta) {
+    nodes++;
+    seldepth = std::max(seldepth, ply);
+    if ((nodes & 1023) == 0 && checkLimits())
+        stop = true;
+    if (stop)
+        return 0;
+
+    bool inCheck = pos.inCheck();
+    MoveList list;
+    pos.generateLegal(list);
+    if (!list.size())
+        return inCheck ? -MateScore + ply : 0;
+    int best = evaluate(pos);
+    if (ply >= MaxPly - 1)
+        return best;
+
+    if (inCheck)
+        best = -MateScore + ply;//every evasion is searched
+    else {
+        if (best >= beta)
+            return best;
+        alpha = std::max(alpha, best);
+        int n = 0;
+        for (Move m : list)
+            if (isCapture(m) || isPromotion(m))
+                list.moves[n++] = m;
+        list.count = n;
+    }
+
+    int scores[256];
+    orderMoves(pos, list, scores, NoMove, ply);
+    UndoInfo undo;
+    for (int i = 0; i < list.size(); i++) {
+        pickNext(list, scores, i);
+        Move m = list[i];
+        pos.doMove(m, undo);
+        int score = -quiesce(pos, ply + 1, -beta, -alpha);
+        pos.undoMove(m, undo);
+        if (stop)
+            return 0;
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta)
+                    break;
+            }
+        }
+    }
+    return best;
+}
+
+int Searcher::alphaBeta (Position& pos, int depth, int ply, int alpha, int beta) {
+    if (depth <= 0)
+        return quiesce(pos, ply, alpha, beta);
+    nodes++;
+    seldepth = std::max(seldepth, ply);
+    if ((nodes & 1023) == 0 && checkLimits())
+        stop = true;
+    if (stop)
+        return 0;
+
+    if (ply > 0) {
+        if (pos.halfmoves >= 100 || isRepetition(pos) || hasInsufficientMaterial(pos))
+            return 0;
+        //no line from here can beat a shorter mate already found
+        alpha = std::max(alpha, -MateScore + ply);
+        beta = std::min(beta, MateScore - ply - 1);
+        if (alpha >= beta)
+            return alpha;
+    }
+
+    TTEntry& entry = table[pos.key & mask];
+    Move ttMove = NoMove;
+    if (entry.key == pos.key) {
+        ttMove = entry.move;
+        if (ply > 0 && entry.depth >= depth) {
+            int score = scoreFromTT(entry.score, ply);
+            if (entry.bound == Exact || (entry.bound == Lower && score >= beta) ||
+                    (entry.bound == Upper && score <= alpha))
+                return score;
+        }
+    }
+
+    MoveList list;
+    pos.generateLegal(list);
+    if (!list.size())
+        return pos.inCheck() ? -MateScore + ply : 0;
+    if (ply >= MaxPly - 1)
+        return evaluate(pos);
+    if (pos.inCheck())
+        depth++;
+
+    int scores[256];
+    orderMoves(pos, list, scores, ttMove, ply);
+
+    int     best        = -MateScore;
+    Move    bestMove    = NoMove;
+    int     alphaOrig   = alpha;
+    UndoInfo undo;
+    for (int i = 0; i < list.size(); i++) {
+        pickNext(list, scores, i);
+        Move m = list[i];
+        keys.push_back(pos.key);
+        pos.doMove(m, undo);
+        int score;
+        //later moves only have to prove they are not better, with a null window
+        if (i == 0)
+            score = -alphaBeta(pos, depth - 1, ply + 1, -beta, -alpha);
+        else {
+            score = -alphaBeta(pos, depth - 1, ply + 1, -alpha - 1, -alpha);
+            if (score > alpha && score < beta)
+                score = -alphaBeta(pos, depth - 1, ply + 1, -beta, -alpha);
+        }
+        pos.undoMove(m, undo);
+        keys.pop_back();
+        if (stop)
+            return 0;
+
+        if (score > best) {
+            best = score;
+            bestMove = m;
+            if (ply == 0)
+                rootBest = m;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) {
+                    if (!isCapture(m) && !isPromotion(m)) {
+                        if (killers[ply][0] != m) {
+                            killers[ply][1] = killers[ply][0];
+                            killers[ply][0] = m;
+                        }
+                        historyScores[pos.side][moveFrom(m)][moveTo(m)] += depth * depth;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    entry.key   = pos.key;
+    entry.move  = bestMove;
+    entry.score = (int16_t)scoreToTT(best, ply);
+    entry.depth = (uint8_t)depth;
+    entry.bound = best >= beta ? Lower : best > alphaOrig ? Exact : Upper;
+    return best;
+}
+
+//principal variation from the table, each move checked since entries can be overwritten
+int Searcher::extractPv (Position pos, Move best, Move* pv, int maxLength) const {
+    int length = 0;
+    Move m = best;
+    while (m != NoMove && length < maxLength) {
+        pv[length++] = m;
+        pos.doMove(m);
+        const TTEntry& entry = table[pos.key & mask];
+        if (entry.key != pos.key)
+            break;
+        m = NoMove;
+        MoveList list;
+        pos.generateLegal(list);
+        for (Move legal : list)
+            if (legal == entry.move)
+                m = legal;
+    }
+    return length;
+}
+
+Move Searcher::search (const Position& pos, const std::vector<uint64_t>& history, const SearchLimits& limits,
+                       SearchInfo& info, const std::function<void(const SearchInfo&)>& onIteration) {
+    info = SearchInfo();
+    MoveList list;
+    pos.generateLegal(list);
+    if (!list.size()) {
+        info.score = pos.inCheck() ? -MateScore : 0;
+        return NoMove;
+    }
+
+    keys            = history;
+    nodes           = 0;
+    seldepth        = 0;
+    completedDepth  = 0;
+    maxNodes        = limits.nodes;
+    timeLimited     = limits.movetime > 0;
+    pondering       = limits.ponder;
+    startTime       = std::chrono::steady_clock::now();
+    deadline        = startTime + std::chrono::milliseconds(limits.movetime);
+    memset (killers, 0, sizeof(killers));
+    for (int c = 0; c < 2; c++)
+        for (int from = 0; from < 64; from++)
+            for (int to = 0; to < 64; to++)
+                historyScores[c][from][to] /= 8;
+
+    Position root = pos;
+    Move best = list[0];
+    for (int depth = 1; depth <= std::min(limits.depth, MaxPly - 1); depth++) {
+        rootBest = NoMove;
+        seldepth = 0;
+        int score = alphaBeta(root, depth, 0, -MateScore, MateScore);
+        if (stop) {
+            //an interrupted iteration is only used when none completed yet
+            if (!completedDepth && rootBest != NoMove)
+                best = rootBest;
+            break;
+        }
+        best = rootBest;
+        completedDepth = depth;
+
+        info.depth      = depth;
+        info.seldepth   = seldepth;
+        info.score      = score;
+        info.nodes      = nodes;
+        info.time       = elapsed();
+        info.pvLength   = extractPv(root, best, info.pv, depth);
+        if (onIteration)
+            onIteration(info);
+
+        //a mate within the horizon will not change, nor a forced move
+        if ((isMateScore(score) && MateScore - std::abs(score) <= depth) || list.size() == 1)
+            break;
+        if (isPondering())
+            continue;
+        //the next iteration takes longer than all the previous ones together
+        if (timeLimited && elapsed() * 2 > limits.movetime)
+            break;
+        if (maxNodes && nodes * 2 > maxNodes)
+            break;
+    }
+    info.nodes  = nodes;
+    info.time   = elapsed();
+    return best;
+}
+
+}
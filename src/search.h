@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <functional>
+
+#include "position.h"
+
+namespace chess {
+
+const int MateScore     = 32000;
+const int MaxPly        = 64;
+
+//mate in n plies is scored MateScore - n
+inline bool isMateScore (int score) { return score > MateScore - MaxPly || score < -MateScore + MaxPly; }
+
+//static evaluation in centipawns for the side to move, material and piece squares
+int evaluate (const Position& pos);
+
+//limits of one search, the first one reached ends it
+struct SearchLimits {
+    int         depth       = MaxPly;
+    int         movetime    = 0;//milliseconds, 0 for no time limit
+    uint64_t    nodes       = 0;//0 for no node limit
+    bool        ponder      = false;//limits are ignored until ponderhit
+};
+
+//result of the last completed iteration
+struct SearchInfo {
+    int         depth       = 0;
+    int         seldepth    = 0;
+    int         score       = 0;//centipawns or mate score, for the side to move
+    uint64_t    nodes       = 0;
+    int         time        = 0;//milliseconds since the search started
+    Move        pv[MaxPly];
+    int         pvLength    = 0;
+};
+
+//Alpha-beta engine run in process: iterative deepening over a negamax search with
+//a transposition table and quiescence on captures. Moves are ordered hash move
+//first, then captures by most valuable victim, killers and history counters.
+class Searcher {
+public:
+    //set from any thread to end the running search, the best move found so far is returned
+    std::atomic<bool>   stop{false};
+    //set from any thread when the pondered move is played, the limits apply from then on
+    std::atomic<bool>   ponderhit{false};
+
+    explicit Searcher (size_t hashMegabytes = 16);
+
+    //forget the previous games, on ucinewgame
+    void    clear ();
+    //search pos within limits, history holds the keys of the game positions before pos
+    //for repetitions. onIteration is called after each completed depth when given.
+    //Return NoMove if pos has no legal move.
+    Move    search (const Position& pos, const std::vector<uint64_t>& history, const SearchLimits& limits,
+                    SearchInfo& info, const std::function<void(const SearchInfo&)>& onIteration = nullptr);
+
+private:
+    enum Bound : uint8_t { Upper, Lower, Exact };
+    struct TTEntry {
+        uint64_t    key;
+        Move        move;
+        int16_t     score;
+        uint8_t     depth;
+        uint8_t     bound;
+    };
+    std::vector<TTEntry>    table;
+    uint64_t                mask;
+
+    Move        killers[MaxPly][2];
+    int         historyScores[2][64][64];
+    std::vector<uint64_t>   keys;//game then search path, for repetitions
+    uint64_t    nodes;
+    int         seldepth;
+    int         completedDepth;
+    Move        rootBest;//best move of the running iteration
+    uint64_t    maxNodes;
+    std::chrono::steady_clock::time_point   startTime, deadline;
+    bool        timeLimited;
+    bool        pondering;
+
+    int     alphaBeta (Position& pos, int depth, int ply, int alpha, int beta);
+    int     quiesce (Position& pos, int ply, int alpha, int beta);
+    bool    isRepetition (const Position& pos) const;
+    void    orderMoves (const Position& pos, MoveList& list, int* scores, Move ttMove, int ply) const;
+    bool    checkLimits ();
+    bool    isPondering ();
+    int     extractPv (Position pos, Move best, Move* pv, int maxLength) const;
+    int     elapsed () const;
+};
+
+}
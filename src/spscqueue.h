@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+
+//Lock free bounded queue for exactly one producer thread and one consumer thread.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+public:
+    //producer side, false if the queue is full
+    bool push (const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity)
+            return false;
+        items[t & (Capacity - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    //consumer side, false if the queue is empty
+    bool pop (T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        item = items[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    size_t size () const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+private:
+    //padding keeps the two indices on separate cache lines without requiring an
+    //over aligned allocation from the owner
+    T                   items[Capacity];
+    char                pad0[64];
+    std::atomic<size_t> head{0};
+    char                pad1[64 - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> tail{0};
+};
@@ -0,0 +1,126 @@
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "ucireader.h"
+
+static bool tokenIs (const char* tok, int len, const char* word) {
+    return (int)strlen(word) == len && strncmp(tok, word, len) == 0;
+}
+static void copyToken (char* dst, const char* tok, int len) {
+    if (len > 7)
+        len = 7;
+    memcpy (dst, tok, len);
+    dst[len] = 0;
+}
+
+bool parseUciLine (const char* line, int length, UciMessage& msg) {
+    memset (&msg, 0, sizeof(UciMessage));
+    msg.line    = line;
+    msg.length  = length;
+
+    //split on spaces, tokens stay in the line
+    const int   maxTokens = 64;
+    const char* tok[maxTokens];
+    int         len[maxTokens];
+    int         count = 0;
+    const char* p = line;
+    const char* e = line + length;
+    while (p < e && count < maxTokens) {
+        while (p < e && (*p == ' ' || *p == '\t'))
+            p++;
+        if (p == e)
+            break;
+        tok[count] = p;
+        while (p < e && *p != ' ' && *p != '\t')
+            p++;
+        len[count] = p - tok[count];
+        count++;
+    }
+    if (!count)
+        return false;
+
+    if (tokenIs(tok[0], len[0], "uciok"))
+        msg.type = UciMessage::UciOk;
+    else if (tokenIs(tok[0], len[0], "readyok"))
+        msg.type = UciMessage::ReadyOk;
+    else if (tokenIs(tok[0], len[0], "bestmove")) {
+        msg.type = UciMessage::BestMove;
+        if (count > 1)
+            copyToken (msg.bestMove, tok[1], len[1]);
+        if (count > 3 && tokenIs(tok[2], len[2], "ponder"))
+            copyToken (msg.ponder, tok[3], len[3]);
+    } else if (tokenIs(tok[0], len[0], "info")) {
+        msg.type = UciMessage::Info;
+        for (int i=1; i<count-1; i++) {
+            if (tokenIs(tok[i], len[i], "depth"))
+                msg.depth = atoi(tok[++i]);
+            else if (tokenIs(tok[i], len[i], "seldepth"))
+                msg.seldepth = atoi(tok[++i]);
+            else if (tokenIs(tok[i], len[i], "score") && i+2 < count) {
+                msg.hasScore    = true;
+                msg.mateScore   = tokenIs(tok[i+1], len[i+1], "mate");
+                msg.score       = atoi(tok[i+2]);
+                i += 2;
+            } else if (tokenIs(tok[i], len[i], "pv")) {
+                copyToken (msg.pv[0], tok[i+1], len[i+1]);
+                if (i+2 < count)
+                    copyToken (msg.pv[1], tok[i+2], len[i+2]);
+                break;//pv is the last field
+            }
+        }
+    } else
+        msg.type = UciMessage::Other;
+    return true;
+}
+
+void UciReader::reset (int _fd) {
+    fd      = _fd;
+    eof     = false;
+    start   = end = 0;
+}
+
+int UciReader::fill () {
+    if (end == sizeof(buffer)) {
+        //only the incomplete last line is moved back to the front
+        memmove (buffer, buffer + start, end - start);
+        end -= start;
+        start = 0;
+        if (end == sizeof(buffer))//single line larger than the buffer, drop it
+            end = 0;
+    }
+    int total = 0;
+    while (end < sizeof(buffer)) {
+        ssize_t n = read(fd, buffer + end, sizeof(buffer) - end);
+        if (n > 0) {
+            end += n;
+            total += n;
+            continue;
+        }
+        if (n == 0)
+            eof = true;
+        else if (errno == EINTR)
+            continue;
+        break;//EAGAIN: nothing more available for now
+    }
+    return total;
+}
+
+bool UciReader::next (UciMessage& msg) {
+    while (start < end) {
+        char* nl = (char*)memchr(buffer + start, '\n', end - start);
+        if (!nl)
+            return false;
+        char* line = buffer + start;
+        int length = nl - line;
+        start += length + 1;
+        if (length && line[length-1] == '\r')
+            length--;
+        if (parseUciLine(line, length, msg))
+            return true;
+    }
+    if (start == end)
+        start = end = 0;
+    return false;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stddef.h>
+
+//one line of engine output with the fields the client uses already parsed
+struct UciMessage {
+    enum Type { Other, UciOk, ReadyOk, Info, BestMove };
+
+    Type        type;
+    const char* line;//points into the reader buffer, not null terminated
+    int         length;
+
+    //info
+    int         depth;
+    int         seldepth;
+    bool        hasScore;
+    bool        mateScore;//score is a mate distance instead of centipawns
+    int         score;
+    char        pv[2][8];//first two moves of the principal variation, empty if missing
+    //bestmove
+    char        bestMove[8];//"(none)" if no legal move
+    char        ponder[8];
+};
+
+//parse one line without its new line character, return false for an empty line
+bool parseUciLine (const char* line, int length, UciMessage& msg);
+
+//Read side of the uci protocol. All bytes available on the non blocking fd are
+//drained at once in a single buffer, complete lines are then handed out in place.
+class UciReader {
+public:
+    int     fd      = -1;
+    bool    eof     = false;
+
+    void    reset (int _fd);
+    //read everything available without blocking, return the bytes read. Messages
+    //previously returned by next() are invalidated.
+    int     fill ();
+    //next complete line, false if none is buffered
+    bool    next (UciMessage& msg);
+
+private:
+    char    buffer[65536];
+    size_t  start   = 0;//first byte not yet handed out
+    size_t  end     = 0;//end of valid data
+};
@@ -0,0 +1,60 @@
+#include <unistd.h>
+#include <iostream>
+
+#include "ucisession.h"
+
+void UciSession::write (const std::string& cmd) {
+    std::string line = cmd + "\n";
+
+#if DEBUG_STOCKFISH
+    std::cout << std::to_string(fd) << " <= " << line;
+#endif
+
+    if (sink)
+        sink->receive(cmd);
+    else
+        ::write(fd, line.c_str(), line.length());
+    commandsSent++;
+    bytesSent += line.length();
+}
+void UciSession::send (const std::string& cmd) {
+    write (cmd);
+    fullGameBytes += cmd.length() + 1;
+}
+
+void UciSession::reset () {
+    skillLevel = -1;
+    positionCmd.clear();
+}
+
+void UciSession::setSkillLevel (int level) {
+    fullGameBytes += 35 + std::to_string(level).length();//"setoption name Skill Level value N\n"
+    if (level == skillLevel)
+        return;
+    skillLevel = level;
+    write ("setoption name Skill Level value " + std::to_string(level));
+}
+
+void UciSession::setPosition (const chess::Position& base, const chess::Move* moves, int first, int count) {
+    std::string cmd = "position ";
+    std::string baseFen = base.fen();
+    if (baseFen == chess::Position().fen())
+        cmd += "startpos";
+    else
+        cmd += "fen " + baseFen;
+
+    if (first < count) {
+        cmd += " moves";
+        for (int i=first; i<count; i++)
+            cmd += " " + chess::moveToUci(moves[i]);
+    }
+
+    fullGameBytes += 24;//"position startpos moves" and new line
+    for (int i=0; i<count; i++)
+        fullGameBytes += 1 + (chess::isPromotion(moves[i]) ? 5 : 4);
+
+    if (cmd == positionCmd)
+        return;
+    positionCmd = cmd;
+    write (cmd);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+
+#include "position.h"
+
+//receives the commands of a session when the engine runs in process instead of behind a pipe
+class UciSink {
+public:
+    virtual ~UciSink () {}
+    virtual void receive (const std::string& cmd) = 0;
+};
+
+//Write side of the uci protocol. It keeps track of what the engine already knows
+//to avoid resending unchanged options and positions, and counts the traffic.
+class UciSession {
+public:
+    int         fd              = -1;
+    UciSink*    sink            = nullptr;//used instead of fd when set
+
+    uint64_t    commandsSent    = 0;
+    uint64_t    bytesSent       = 0;
+    //estimate, not measured traffic: bytes the same session would cost when resending the
+    //skill level and the whole game from startpos each time
+    uint64_t    fullGameBytes   = 0;
+
+    //send one command line, the new line is appended
+    void send (const std::string& cmd);
+    //forget engine state, on new game or engine restart
+    void reset ();
+
+    void setSkillLevel (int level);
+    //send the position reached from base by moves[first..count[, moves[0..first[ being the
+    //moves that lead to base. Base is given as fen unless it is the start position, and
+    //nothing is sent if the engine already has this position.
+    void setPosition (const chess::Position& base, const chess::Move* moves, int first, int count);
+
+private:
+    int         skillLevel      = -1;
+    std::string positionCmd;
+
+    void write (const std::string& cmd);
+};